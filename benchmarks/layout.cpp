@@ -0,0 +1,257 @@
+#include "widget/object.h"
+#include "damage_region.h"
+#include "job_system.h"
+
+#include <chrono>
+#include <random>
+
+//
+// Lays out a screen of rows of labels, the way a long list or a table is built, and measures how long
+// laying it out again takes after one label changed size, compared with laying out the whole screen.
+// Then lays out a dashboard of fixed-size panels from scratch on job systems with more and more workers,
+// and checks that every one of them places every widget where a single thread does.
+//
+//     BenchLayout [row_count] [labels_per_row] [iteration_count] [max_worker_count]
+//
+
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using namespace maple;
+
+double to_ms(Clock::duration duration_)
+{
+    return std::chrono::duration<double, std::milli>(duration_).count();
+}
+
+template <typename Function>
+double measure(int iterations_, Function&& function_)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < iterations_; i++)
+        function_(i);
+    return to_ms(Clock::now() - start) / iterations_;
+}
+
+//
+// A widget with content of a given size, standing in for text.
+//
+class Label : public Frame
+{
+public:
+    static std::shared_ptr<Label> create(std::shared_ptr<Object> parent_, const Size& content_size_)
+    {
+        struct MakeSharedEnabler : public Label
+        {
+            MakeSharedEnabler(std::shared_ptr<Object> parent_)
+                : Label(parent_) {}
+        };
+        auto label = std::make_shared<MakeSharedEnabler>(parent_);
+        label->set_content_size(content_size_);
+        parent_->add_child(label);
+        return label;
+    }
+
+protected:
+    Label(std::shared_ptr<Object> parent_)
+        : Frame(parent_)
+    {
+        set_custom_measure(true);
+    }
+
+public:
+    virtual Size measure(const LayoutConstraints&) override
+    {
+        return m_content_size;
+    }
+
+    void set_content_size(const Size& content_size_)
+    {
+        m_content_size = content_size_;
+        invalidate_layout();
+    }
+
+    const WidgetStorage::Statistics& get_statistics() const
+    {
+        return get_storage().get_statistics();
+    }
+
+private:
+    Size m_content_size{};
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Dashboard
+{
+    std::shared_ptr<Frame> root;
+    std::vector<std::shared_ptr<Label>> labels;
+};
+
+Dashboard build_dashboard(std::size_t widget_count_)
+{
+    constexpr std::size_t rows_per_panel = 20;
+    constexpr std::size_t labels_per_row = 40;
+    std::size_t panel_count = std::max<std::size_t>(widget_count_ / (rows_per_panel * (labels_per_row + 1)), 1);
+
+    Dashboard dashboard;
+    dashboard.root = Frame::create(nullptr, Rect{ .x = 0, .y = 0, .width = 1920, .height = 1080 }, Color{});
+    dashboard.root->set_layout_style(LayoutStyle{ .direction = FlexDirection::row, .gap = 4 });
+    for (std::size_t i = 0; i < panel_count; i++)
+    {
+        auto panel = Frame::create(dashboard.root);
+        panel->set_layout_style(LayoutStyle{ .direction = FlexDirection::column, .padding = 4, .gap = 2,
+                                             .width = 240, .height = 1000 });
+        for (std::size_t j = 0; j < rows_per_panel; j++)
+        {
+            auto row = Frame::create(panel);
+            row->set_layout_style(LayoutStyle{ .direction = FlexDirection::row, .justify = FlexJustify::space_between,
+                                               .align = FlexAlign::center, .grow = 1.0f });
+            for (std::size_t k = 0; k < labels_per_row; k++)
+                dashboard.labels.push_back(Label::create(row, Size{ .width = 4 + static_cast<int>(k % 5),
+                                                                    .height = 8 + static_cast<int>(j % 3) }));
+        }
+    }
+    return dashboard;
+}
+
+//
+// The time of a full layout, every label invalidated beforehand.
+//
+double measure_full_layout(Dashboard& dashboard_, JobSystem* job_system_, int iterations_)
+{
+    Clock::duration total{ 0 };
+    for (int i = 0; i < iterations_; i++)
+    {
+        for (auto& label : dashboard_.labels)
+            label->invalidate_layout();
+
+        auto start = Clock::now();
+        dashboard_.root->layout(job_system_);
+        total += Clock::now() - start;
+    }
+    return to_ms(total) / iterations_;
+}
+
+std::vector<Rect> get_rects(const Dashboard& dashboard_)
+{
+    std::vector<Rect> rects;
+    rects.reserve(dashboard_.labels.size());
+    for (auto& label : dashboard_.labels)
+        rects.push_back(label->get_rect());
+    return rects;
+}
+
+bool is_same_rects(const std::vector<Rect>& a_, const std::vector<Rect>& b_)
+{
+    return std::ranges::equal(a_, b_, [](const Rect& a_, const Rect& b_)
+        {
+            return a_.x == b_.x && a_.y == b_.y && a_.width == b_.width && a_.height == b_.height;
+        });
+}
+
+}
+
+
+
+int main(int argc, char** argv)
+{
+    std::size_t row_count = argc > 1 ? std::stoul(argv[1]) : 500;
+    std::size_t labels_per_row = argc > 2 ? std::stoul(argv[2]) : 100;
+    int iterations = argc > 3 ? std::stoi(argv[3]) : 100;
+    std::size_t max_worker_count = argc > 4 ? std::stoul(argv[4])
+                                            : std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+    auto root = Frame::create(nullptr, Rect{ .x = 0, .y = 0, .width = 1920, .height = 1080 }, Color{});
+    root->set_layout_style(LayoutStyle{ .direction = FlexDirection::column, .padding = 8, .gap = 2 });
+
+    std::vector<std::shared_ptr<Label>> labels;
+    labels.reserve(row_count * labels_per_row);
+    for (std::size_t i = 0; i < row_count; i++)
+    {
+        auto row = Frame::create(root);
+        row->set_layout_style(LayoutStyle{ .direction = FlexDirection::row, .align = FlexAlign::center, .gap = 4 });
+        for (std::size_t j = 0; j < labels_per_row; j++)
+            labels.push_back(Label::create(row, Size{ .width = 10 + static_cast<int>(j % 7), .height = 12 }));
+    }
+
+    std::cout << row_count * (labels_per_row + 1) + 1 << " widgets, " << iterations << " iterations\n";
+
+    DamageRegion damage;
+    auto print = [&labels](const std::string& name_, double ms_)
+        {
+            auto& statistics = labels.front()->get_statistics();
+            std::cout << name_ << ": " << ms_ << " ms, " << statistics.arranged_rows << " containers arranged, "
+                      << statistics.measured_rows << " widgets measured\n";
+        };
+
+    auto start = Clock::now();
+    root->layout();
+    print("first layout", to_ms(Clock::now() - start));
+    root->update(damage);
+
+    // one label changes size, only its row and the root are arranged again
+
+    std::mt19937 random{ 7 };
+    double incremental = measure(iterations, [&](int i_)
+        {
+            labels[random() % labels.size()]->set_content_size(Size{ .width = 10 + i_ % 13, .height = 12 });
+            root->layout();
+        });
+    print("relayout after resizing one label", incremental);
+
+    // resizing the window changes the size of every row
+
+    double resize = measure(iterations, [&](int i_)
+        {
+            root->set_rect(Rect{ .x = 0, .y = 0, .width = 1920 - i_ % 2, .height = 1080 });
+            root->layout();
+        });
+    print("relayout after resizing the window", resize);
+
+    // without caches every widget is measured again, as an engine without dirty tracking would
+
+    double full = measure(std::max(iterations / 10, 1), [&](int i_)
+        {
+            root->set_layout_style(LayoutStyle{ .direction = FlexDirection::column, .padding = 8 + i_ % 2, .gap = 2 });
+            for (auto& label : labels)
+                label->invalidate_layout();
+            root->layout();
+        });
+    print("full layout", full);
+
+    // panels with a fixed size are laid out independently of each other
+
+    Dashboard dashboard = build_dashboard(row_count * (labels_per_row + 1));
+    std::cout << "\ndashboard of " << dashboard.labels.size() << " labels, " << std::thread::hardware_concurrency()
+              << " cores\n";
+
+    int layout_iterations = std::max(iterations / 10, 1);
+    dashboard.root->layout();
+    double single = measure_full_layout(dashboard, nullptr, layout_iterations);
+    std::vector<Rect> expected = get_rects(dashboard);
+    std::cout << "full layout, one thread: " << single << " ms\n";
+
+    bool is_passed = true;
+    for (std::size_t worker_count = 1; worker_count <= max_worker_count; worker_count *= 2)
+    {
+        auto job_system = JobSystem::create(worker_count);
+        double parallel = measure_full_layout(dashboard, job_system.get(), layout_iterations);
+        bool is_same = is_same_rects(get_rects(dashboard), expected);
+        is_passed &= is_same;
+        std::cout << "full layout, " << worker_count << " workers: " << parallel << " ms, "
+                  << single / parallel << "x" << (is_same ? "" : ", DIFFERENT RESULT") << "\n";
+
+        // the last entry is the thread running the benchmark, which helps while waiting
+        auto statistics = job_system->get_worker_statistics();
+        for (std::size_t i = 0; i < statistics.size(); i++)
+            std::cout << "    " << (i < worker_count ? "worker " + std::to_string(i) : std::string("main thread"))
+                      << ": " << statistics[i].executed_jobs << " jobs, " << statistics[i].stolen_jobs
+                      << " stolen, " << statistics[i].utilization * 100.0 << "% busy\n";
+    }
+
+    return is_passed ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+#include "opengl_util/general.h"
+#include "opengl_util/rect_batch.h"
+
+#include <glad/gl.h>
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <random>
+
+//
+// Compares the single-quad path (one glDrawArrays and a uniform upload by name per rectangle)
+// against gl::RectBatch (one instanced draw call per material) for the same set of rectangles.
+//
+//     BenchRectBatch [rect_count] [frame_count]
+//
+
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+std::string single_vertex = R"(
+    #version 330 core
+    layout (location = 0) in vec3 position;
+
+    uniform vec4 u_rect;
+    uniform vec2 u_viewport;
+
+    void main()
+    {
+        vec2 pixel = u_rect.xy + position.xy * u_rect.zw;
+        gl_Position = vec4(pixel / u_viewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
+    }
+)";
+
+std::string single_fragment = R"(
+    #version 330 core
+    layout (location = 0) out vec4 frag_color;
+
+    uniform vec4 u_color;
+
+    void main()
+    {
+        frag_color = u_color;
+    }
+)";
+
+std::string batch_vertex = R"(
+    #version 330 core
+    layout (location = 0) in vec4 i_rect;
+    layout (location = 1) in vec4 i_color;
+    layout (location = 2) in float i_corner_radius;
+
+    uniform vec2 u_viewport;
+
+    out vec4 v_color;
+
+    void main()
+    {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 pixel = i_rect.xy + corner * i_rect.zw;
+
+        v_color = i_color;
+        gl_Position = vec4(pixel / u_viewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
+    }
+)";
+
+std::string batch_fragment = R"(
+    #version 330 core
+    layout (location = 0) out vec4 frag_color;
+
+    in vec4 v_color;
+
+    void main()
+    {
+        frag_color = v_color;
+    }
+)";
+
+struct Result
+{
+    double cpu_ms{ 0.0 };
+    double frame_ms{ 0.0 };
+    std::size_t draw_calls{ 0 };
+};
+
+void print_result(const char* name_, const Result& result_)
+{
+    std::cout << name_ << ": "
+              << "cpu " << result_.cpu_ms << " ms/frame, "
+              << "cpu+gpu " << result_.frame_ms << " ms/frame, "
+              << result_.draw_calls << " draw calls/frame\n";
+}
+
+std::vector<maple::gl::RectInstance> generate_rects(std::size_t count_, const maple::Size& viewport_)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> x(0.0f, static_cast<float>(viewport_.width));
+    std::uniform_real_distribution<float> y(0.0f, static_cast<float>(viewport_.height));
+    std::uniform_real_distribution<float> extent(4.0f, 64.0f);
+    std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+    std::vector<maple::gl::RectInstance> rects(count_);
+    for (auto& rect : rects)
+        rect = maple::gl::RectInstance{
+            .x = x(rng), .y = y(rng), .width = extent(rng), .height = extent(rng),
+            .r = channel(rng), .g = channel(rng), .b = channel(rng), .a = 1.0f,
+            .corner_radius = 0.0f
+        };
+    return rects;
+}
+
+template <typename DrawFrame>
+Result measure(int frames_, DrawFrame&& draw_frame_)
+{
+    for (int i = 0; i < 10; i++)
+        draw_frame_();
+    glFinish();
+
+    Result result;
+    for (int i = 0; i < frames_; i++)
+    {
+        auto start = Clock::now();
+        result.draw_calls = draw_frame_();
+        auto submitted = Clock::now();
+        glFinish();
+        auto finished = Clock::now();
+
+        result.cpu_ms   += std::chrono::duration<double, std::milli>(submitted - start).count();
+        result.frame_ms += std::chrono::duration<double, std::milli>(finished - start).count();
+    }
+    result.cpu_ms /= frames_;
+    result.frame_ms /= frames_;
+    return result;
+}
+
+}
+
+
+
+int main(int argc, char** argv)
+{
+    std::size_t rect_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+    int frame_count = argc > 2 ? std::stoi(argv[2]) : 200;
+    maple::Size viewport{ .width = 1280, .height = 720 };
+
+    if (!glfwInit())
+        throw std::runtime_error("int main(): Failed to initialize GLFW. glfwInit()");
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, maple::configuration::opengl_version_major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, maple::configuration::opengl_version_minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(viewport.width, viewport.height, "BenchRectBatch", nullptr, nullptr);
+    if (!window)
+        throw std::runtime_error("int main(): Failed to create window. glfwCreateWindow()");
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGL(glfwGetProcAddress))
+        throw std::runtime_error("int main(): Failed to create opengl context. gladLoadGL()");
+    glViewport(0, 0, viewport.width, viewport.height);
+
+    using namespace maple::gl;
+
+    auto rects = generate_rects(rect_count, viewport);
+    std::cout << rect_count << " rects, " << frame_count << " frames, "
+              << glGetString(GL_RENDERER) << "\n";
+
+    {
+        auto vb = VertexBuffer::create();
+        float vertices[] = {
+                0.0f, 0.0f, 0.0f,
+                1.0f, 0.0f, 0.0f,
+                1.0f, 1.0f, 0.0f,
+                1.0f, 1.0f, 0.0f,
+                0.0f, 1.0f, 0.0f,
+                0.0f, 0.0f, 0.0f
+        };
+        vb->bind();
+        glBufferData(GL_ARRAY_BUFFER, sizeof vertices, vertices, GL_STATIC_DRAW);
+        auto va = VertexArray::create();
+        va->bind();
+        vb->bind();
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void*>(0));
+        glEnableVertexAttribArray(0);
+        auto shader = Shader::create(single_vertex, single_fragment);
+
+        auto result = measure(frame_count, [&]
+            {
+                glClear(GL_COLOR_BUFFER_BIT);
+                shader->bind();
+                va->bind();
+                glUniform2f(glGetUniformLocation(shader->get_id(), std::string("u_viewport").c_str()),
+                            static_cast<float>(viewport.width), static_cast<float>(viewport.height));
+                for (auto& rect : rects)
+                {
+                    glUniform4f(glGetUniformLocation(shader->get_id(), std::string("u_rect").c_str()),
+                                rect.x, rect.y, rect.width, rect.height);
+                    glUniform4f(glGetUniformLocation(shader->get_id(), std::string("u_color").c_str()),
+                                rect.r, rect.g, rect.b, rect.a);
+                    glDrawArrays(GL_TRIANGLES, 0, 6);
+                }
+                return rects.size();
+            });
+        print_result("single quad", result);
+    }
+
+    {
+        auto batch = RectBatch::create();
+        auto va = VertexArray::create();
+        batch->setup_vertex_array(*va);
+        auto shader = Shader::create(batch_vertex, batch_fragment);
+
+        auto result = measure(frame_count, [&]
+            {
+                glClear(GL_COLOR_BUFFER_BIT);
+                batch->begin();
+                for (auto& rect : rects)
+                    batch->submit(shader, rect);
+                batch->flush(*va, viewport);
+                return batch->get_statistics().draw_calls;
+            });
+        print_result("rect batch ", result);
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return 0;
+}
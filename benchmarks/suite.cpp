@@ -0,0 +1,486 @@
+#include "context.h"
+#include "painter.h"
+#include "opengl_util/general.h"
+#include "opengl_util/timer_query.h"
+
+#include <glad/gl.h>
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+//
+// Runs a fixed set of scenes and writes the results as JSON, so results of two releases can be diffed.
+// Windowed scenes draw through a headless Context, the others use OpenGL objects directly in a hidden window.
+//
+//     BenchSuite [--frames N] [--filter text] [--output file.json]
+//
+// N is the number of frames per scene, from 1 to 200, and 200 by default.
+// Results are written to benchmark_results.json by default, since Context prints the renderer to stdout.
+// GPU times and draw calls of windowed scenes come from the FrameTimeline, so they are only reported
+// when the library was built with MAPLE_ENABLE_INSTRUMENTATION, and are null otherwise. So is input latency.
+//
+
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    int frames{ 200 };
+    std::string filter{};
+    std::string output{ "benchmark_results.json" };
+};
+
+struct SceneResult
+{
+    std::string name{};
+    int frames{ 0 };
+    double fps{ 0.0 };
+    std::vector<double> cpu_ms{};
+    std::vector<double> gpu_ms{};
+    std::optional<double> draw_calls{};
+    std::vector<std::pair<std::string, double>> extra{};
+};
+
+std::string rect_vertex = R"(
+    #version 330 core
+    layout (location = 0) in vec4 i_rect;
+
+    uniform vec2 u_viewport;
+
+    void main()
+    {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 pixel = i_rect.xy + corner * i_rect.zw;
+        gl_Position = vec4(pixel / u_viewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
+    }
+)";
+
+std::string rect_fragment = R"(
+    #version 330 core
+    layout (location = 0) out vec4 frag_color;
+
+    void main()
+    {
+        frag_color = vec4(%f, 0.5, 0.5, 1.0);
+    }
+)";
+
+// --------------------------------------------------------------------------------------------------------------------
+
+double to_ms(Clock::duration duration_)
+{
+    return std::chrono::duration<double, std::milli>(duration_).count();
+}
+
+//
+// Nearest-rank percentile of an unsorted sample.
+//
+double percentile(std::vector<double> values_, double percent_)
+{
+    if (values_.empty())
+        return 0.0;
+
+    std::sort(values_.begin(), values_.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(percent_ / 100.0 * values_.size()));
+    return values_[std::clamp<std::size_t>(rank, 1, values_.size()) - 1];
+}
+
+void write_percentiles(std::ostream& stream_, const std::vector<double>& values_)
+{
+    if (values_.empty())
+    {
+        stream_ << "null";
+        return;
+    }
+
+    stream_ << "{ \"p50\": " << percentile(values_, 50.0)
+            << ", \"p90\": " << percentile(values_, 90.0)
+            << ", \"p99\": " << percentile(values_, 99.0)
+            << ", \"max\": " << percentile(values_, 100.0) << " }";
+}
+
+void write_results(std::ostream& stream_, const std::string& renderer_, const std::vector<SceneResult>& results_)
+{
+    stream_ << "{\n"
+            << "  \"renderer\": \"" << renderer_ << "\",\n"
+#ifdef MAPLE_ENABLE_INSTRUMENTATION
+            << "  \"instrumented\": true,\n"
+#else
+            << "  \"instrumented\": false,\n"
+#endif
+            << "  \"scenes\": [";
+
+    for (std::size_t i = 0; i < results_.size(); i++)
+    {
+        auto& result = results_[i];
+        stream_ << (i == 0 ? "\n" : ",\n")
+                << "    {\n"
+                << "      \"name\": \"" << result.name << "\",\n"
+                << "      \"frames\": " << result.frames << ",\n"
+                << "      \"fps\": " << result.fps << ",\n"
+                << "      \"cpu_ms\": ";
+        write_percentiles(stream_, result.cpu_ms);
+        stream_ << ",\n      \"gpu_ms\": ";
+        write_percentiles(stream_, result.gpu_ms);
+        stream_ << ",\n      \"draw_calls\": ";
+        if (result.draw_calls)
+            stream_ << *result.draw_calls;
+        else
+            stream_ << "null";
+        for (auto& [key, value] : result.extra)
+            stream_ << ",\n      \"" << key << "\": " << value;
+        stream_ << "\n    }";
+    }
+
+    stream_ << "\n  ]\n}\n";
+}
+
+std::vector<maple::Rect> generate_rects(std::size_t count_, const maple::Size& viewport_)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> x(0, viewport_.width);
+    std::uniform_int_distribution<int> y(0, viewport_.height);
+    std::uniform_int_distribution<int> extent(4, 64);
+
+    std::vector<maple::Rect> rects(count_);
+    for (auto& rect : rects)
+        rect = maple::Rect{ .x = x(rng), .y = y(rng), .width = extent(rng), .height = extent(rng) };
+    return rects;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Redraws every window in full for the given number of frames through Context::draw.
+// Windows are invalidated by a posted input event, so the scene also reports input-to-photon latency.
+// A few more frames are drawn afterwards, since GPU times of a frame are only collected by later frames.
+//
+SceneResult run_windowed_scene(const std::string& name_, int frames_, int window_count_, std::size_t rect_count_)
+{
+    using namespace maple;
+
+    Size size{ .width = 1280, .height = 720 };
+    if (window_count_ > 1)
+        size = Size{ .width = 320, .height = 240 };
+
+    auto context = Context::create(ContextProperties{ .shader_cache_directory = {},
+                                                      .is_headless = true,
+                                                      .is_render_thread_enabled = false });
+
+    auto rects = generate_rects(rect_count_, size);
+    std::vector<std::shared_ptr<Window>> windows;
+    for (int i = 0; i < window_count_; i++)
+    {
+        auto window = Window::create(context, WindowProperties{ .size = size, .position = {}, .title = name_ });
+        window->on_paint([&rects](Painter& painter_)
+            {
+                for (std::size_t j = 0; j < rects.size(); j++)
+                    painter_.fill_rect(rects[j], Color{ .r = (j % 7) / 7.0f, .g = (j % 5) / 5.0f,
+                                                        .b = (j % 3) / 3.0f, .a = 1.0f });
+            });
+        window->on_input([window = window.get()](const InputEvent&) { window->invalidate(); });
+        windows.push_back(window);
+    }
+
+    auto draw_frame = [&]
+        {
+            for (auto& window : windows)
+                window->post_input(InputEvent{ .type = InputEventType::cursor_move });
+            context->draw();
+        };
+
+    for (int i = 0; i < 10; i++)
+        draw_frame();
+    windows.front()->read_pixels();
+    context->get_frame_timeline().clear();
+    for (auto& window : windows)
+        window->reset_input_latency();
+
+    SceneResult result{ .name = name_, .frames = frames_ };
+    auto start = Clock::now();
+    for (int i = 0; i < frames_; i++)
+    {
+        auto frame_start = Clock::now();
+        draw_frame();
+        result.cpu_ms.push_back(to_ms(Clock::now() - frame_start));
+    }
+    windows.front()->read_pixels();
+    result.fps = frames_ / std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (int i = 0; i < 4; i++)
+        draw_frame();
+
+    MAPLE_INSTRUMENT(
+        auto records = context->get_frame_timeline().get_records();
+        std::size_t draw_calls = 0;
+        std::size_t measured = 0;
+        for (std::size_t i = 0; i < records.size() && measured < static_cast<std::size_t>(frames_); i++, measured++)
+        {
+            auto& record = records[i];
+            draw_calls += record.draw_calls;
+
+            std::chrono::nanoseconds gpu{ 0 };
+            for (auto& pass : record.gpu_passes)
+                gpu += pass;
+            if (gpu.count() > 0)
+                result.gpu_ms.push_back(std::chrono::duration<double, std::milli>(gpu).count());
+        }
+        if (measured > 0)
+            result.draw_calls = static_cast<double>(draw_calls) / measured;
+
+        auto latency = windows.front()->get_input_latency();
+        result.extra.emplace_back("input_to_swap_p50_ms", to_ms(latency.swap.p50));
+        result.extra.emplace_back("input_to_swap_p99_ms", to_ms(latency.swap.p99));
+        result.extra.emplace_back("input_to_gpu_p50_ms", to_ms(latency.gpu.p50));
+        result.extra.emplace_back("input_to_gpu_p99_ms", to_ms(latency.gpu.p99));
+    )
+
+    for (auto& window : windows)
+        window->close();
+    context->draw();
+
+    return result;
+}
+
+//
+// Builds programs from sources that differ in a constant, so the driver cannot return a cached binary.
+//
+SceneResult run_shader_scene(int shader_count_)
+{
+    SceneResult result{ .name = "shader_creation", .frames = shader_count_ };
+
+    auto start = Clock::now();
+    for (int i = 0; i < shader_count_; i++)
+    {
+        char fragment[512];
+        std::snprintf(fragment, sizeof fragment, rect_fragment.c_str(), i / static_cast<double>(shader_count_));
+
+        auto shader_start = Clock::now();
+        auto shader = maple::gl::Shader::create(rect_vertex, fragment);
+        result.cpu_ms.push_back(to_ms(Clock::now() - shader_start));
+    }
+    result.fps = shader_count_ / std::chrono::duration<double>(Clock::now() - start).count();
+    result.extra.emplace_back("shaders_per_second", result.fps);
+
+    return result;
+}
+
+//
+// Starts every program through ShaderFuture before waiting for any, so a driver with parallel shader compile
+// builds them at once, then polls until all are ready and takes each. The constants differ from
+// run_shader_scene, so neither scene gets binaries the driver cached for the other.
+// cpu_ms holds the time each create took to return.
+//
+SceneResult run_async_shader_scene(int shader_count_)
+{
+    using namespace maple::gl;
+
+    SceneResult result{ .name = "shader_creation_async", .frames = shader_count_ };
+
+    auto start = Clock::now();
+    std::vector<std::shared_ptr<ShaderFuture>> futures;
+    for (int i = 0; i < shader_count_; i++)
+    {
+        char fragment[512];
+        std::snprintf(fragment, sizeof fragment, rect_fragment.c_str(), (i + 0.5) / static_cast<double>(shader_count_));
+
+        auto shader_start = Clock::now();
+        futures.push_back(ShaderFuture::create(rect_vertex, fragment));
+        result.cpu_ms.push_back(to_ms(Clock::now() - shader_start));
+    }
+
+    std::size_t polls = 0;
+    while (!std::ranges::all_of(futures, [](auto& future_) { return future_->is_ready(); }))
+    {
+        polls++;
+        std::this_thread::yield();
+    }
+
+    for (auto& future : futures)
+        if (!future->get())
+            throw std::runtime_error("SceneResult run_async_shader_scene(int): A shader future returned no shader.");
+
+    result.fps = shader_count_ / std::chrono::duration<double>(Clock::now() - start).count();
+    result.extra.emplace_back("shaders_per_second", result.fps);
+    result.extra.emplace_back("parallel_compile", ShaderFuture::is_parallel_compile_supported() ? 1.0 : 0.0);
+    result.extra.emplace_back("ready_polls", static_cast<double>(polls));
+
+    return result;
+}
+
+//
+// Streams a fixed amount of instance data per frame through a persistently mapped buffer and draws it once.
+//
+SceneResult run_streaming_scene(int frames_, std::size_t bytes_per_frame_)
+{
+    using namespace maple::gl;
+
+    std::ostringstream name;
+    name << "buffer_streaming_" << bytes_per_frame_ / 1024 << "k";
+    SceneResult result{ .name = name.str(), .frames = frames_ };
+
+    auto buffer = StreamBuffer::create(bytes_per_frame_);
+    auto va = VertexArray::create();
+    glEnableVertexArrayAttrib(va->get_id(), 0);
+    glVertexArrayAttribFormat(va->get_id(), 0, 4, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(va->get_id(), 0, 0);
+    glVertexArrayBindingDivisor(va->get_id(), 0, 1);
+
+    char fragment[512];
+    std::snprintf(fragment, sizeof fragment, rect_fragment.c_str(), 1.0);
+    auto shader = Shader::create(rect_vertex, fragment);
+    auto viewport = shader->get_uniform("u_viewport");
+
+    std::vector<float> source(bytes_per_frame_ / sizeof(float));
+    for (std::size_t i = 0; i < source.size(); i++)
+        source[i] = static_cast<float>(i % 64);
+    int instance_count = static_cast<int>(bytes_per_frame_ / (4 * sizeof(float)));
+
+    auto timer = TimerQueryPool::create(8, 1);
+    std::vector<TimerQueryPool::Result> gpu_results;
+
+    auto start = Clock::now();
+    for (int i = 0; i < frames_; i++)
+    {
+        auto frame_start = Clock::now();
+        timer->collect(gpu_results);
+        timer->begin_frame(i);
+        timer->begin_pass(0);
+
+        auto allocation = buffer->allocate(bytes_per_frame_, 16);
+        std::memcpy(allocation.data, source.data(), bytes_per_frame_);
+        glVertexArrayVertexBuffer(va->get_id(), 0, buffer->get_id(), allocation.offset, 4 * sizeof(float));
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        shader->bind();
+        shader->set_uniform_vec2(viewport, 1280.0f, 720.0f);
+        va->bind();
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instance_count);
+        buffer->fence();
+
+        timer->end_frame();
+        result.cpu_ms.push_back(to_ms(Clock::now() - frame_start));
+    }
+    glFinish();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.fps = frames_ / seconds;
+    result.draw_calls = 1.0;
+    result.extra.emplace_back("gigabytes_per_second", bytes_per_frame_ * frames_ / seconds / 1e9);
+    result.extra.emplace_back("stalls", static_cast<double>(buffer->get_statistics().stalls));
+
+    timer->collect(gpu_results);
+    for (auto& gpu_result : gpu_results)
+        result.gpu_ms.push_back(std::chrono::duration<double, std::milli>(gpu_result.duration).count());
+
+    return result;
+}
+
+Options parse_options(int argc_, char** argv_)
+{
+    Options options;
+    for (int i = 1; i + 1 < argc_; i += 2)
+    {
+        std::string_view key = argv_[i];
+        if (key == "--frames")
+            options.frames = std::stoi(argv_[i + 1]);
+        else if (key == "--filter")
+            options.filter = argv_[i + 1];
+        else if (key == "--output")
+            options.output = argv_[i + 1];
+        else
+            throw std::runtime_error("Options parse_options(int, char**): Unknown option " + std::string(key) + ".");
+    }
+
+    // GPU times of windowed scenes are read back from a FrameTimeline with the default capacity
+
+    if (options.frames < 1 || options.frames > 200)
+        throw std::runtime_error("Options parse_options(int, char**): --frames must be between 1 and 200, not "
+                                 + std::to_string(options.frames) + ".");
+    return options;
+}
+
+}
+
+
+
+int main(int argc, char** argv)
+{
+    Options options = parse_options(argc, argv);
+    auto is_selected = [&options](const std::string& name_)
+        {
+            return options.filter.empty() || name_.find(options.filter) != std::string::npos;
+        };
+
+    std::vector<SceneResult> results;
+    for (std::size_t rect_count : { 1, 100, 1000, 10000, 100000 })
+    {
+        std::string name = "rects_" + std::to_string(rect_count);
+        if (is_selected(name))
+        {
+            std::cerr << name << "\n";
+            results.push_back(run_windowed_scene(name, options.frames, 1, rect_count));
+        }
+    }
+    if (is_selected("many_windows"))
+    {
+        std::cerr << "many_windows\n";
+        results.push_back(run_windowed_scene("many_windows", options.frames, 16, 100));
+    }
+
+    if (!glfwInit())
+        throw std::runtime_error("int main(): Failed to initialize GLFW. glfwInit()");
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, maple::configuration::opengl_version_major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, maple::configuration::opengl_version_minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(1280, 720, "BenchSuite", nullptr, nullptr);
+    if (!window)
+        throw std::runtime_error("int main(): Failed to create window. glfwCreateWindow()");
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGL(glfwGetProcAddress))
+        throw std::runtime_error("int main(): Failed to create opengl context. gladLoadGL()");
+    glViewport(0, 0, 1280, 720);
+
+    std::string renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+    if (is_selected("shader_creation"))
+    {
+        std::cerr << "shader_creation\n";
+        results.push_back(run_shader_scene(50));
+    }
+    if (is_selected("shader_creation_async"))
+    {
+        std::cerr << "shader_creation_async\n";
+        results.push_back(run_async_shader_scene(50));
+    }
+    for (std::size_t bytes : { 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 })
+    {
+        std::string name = "buffer_streaming_" + std::to_string(bytes / 1024) + "k";
+        if (is_selected(name))
+        {
+            std::cerr << name << "\n";
+            results.push_back(run_streaming_scene(options.frames, bytes));
+        }
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    std::ofstream file(options.output);
+    if (!file)
+        throw std::runtime_error("int main(): Failed to open " + options.output + ".");
+    write_results(file, renderer, results);
+    std::cerr << "results written to " << options.output << "\n";
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "widget/object.h"
+#include "damage_region.h"
+
+#include <chrono>
+#include <random>
+
+//
+// Walks a large widget tree the way every frame does, and compares the flat tables of WidgetStorage
+// with a tree of individually allocated nodes, once allocated in build order and once in random order,
+// as nodes end up after a long running application created and destroyed widgets.
+//
+//     BenchWidgetTree [node_count] [iteration_count]
+//
+
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using namespace maple;
+
+constexpr std::size_t fan_out = 10;
+
+double to_ms(Clock::duration duration_)
+{
+    return std::chrono::duration<double, std::milli>(duration_).count();
+}
+
+template <typename Function>
+double measure(int iterations_, Function&& function_)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < iterations_; i++)
+        function_(i);
+    return to_ms(Clock::now() - start) / iterations_;
+}
+
+Rect get_child_rect(std::size_t index_)
+{
+    return Rect{ .x = static_cast<int>(index_ % 7), .y = static_cast<int>(index_ % 5), .width = 8, .height = 8 };
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Node
+{
+    Rect rect{};
+    Rect world_rect{};
+    std::vector<Node*> children{};
+};
+
+void update_nodes(Node& node_, const Point& origin_)
+{
+    node_.world_rect = Rect{ .x = origin_.x + node_.rect.x, .y = origin_.y + node_.rect.y,
+                             .width = node_.rect.width, .height = node_.rect.height };
+    for (Node* child : node_.children)
+        update_nodes(*child, Point{ .x = node_.world_rect.x, .y = node_.world_rect.y });
+}
+
+//
+// Builds the same shape as build_widgets, breadth first, from nodes allocated in the given order.
+//
+void link_nodes(std::vector<std::unique_ptr<Node>>& nodes_)
+{
+    for (std::size_t i = 1; i < nodes_.size(); i++)
+    {
+        nodes_[i]->rect = get_child_rect(i);
+        nodes_[(i - 1) / fan_out]->children.push_back(nodes_[i].get());
+    }
+}
+
+std::vector<std::unique_ptr<Node>> allocate_nodes(std::size_t count_, bool is_shuffled_)
+{
+    std::vector<std::unique_ptr<Node>> nodes(count_);
+    std::vector<std::size_t> order(count_);
+    for (std::size_t i = 0; i < count_; i++)
+        order[i] = i;
+    if (is_shuffled_)
+        std::shuffle(order.begin(), order.end(), std::mt19937{ 42 });
+
+    for (std::size_t index : order)
+        nodes[index] = std::make_unique<Node>();
+    link_nodes(nodes);
+    return nodes;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::vector<std::shared_ptr<Frame>> build_widgets(std::size_t count_)
+{
+    std::vector<std::shared_ptr<Frame>> widgets;
+    widgets.reserve(count_);
+    widgets.push_back(Frame::create(nullptr, Rect{ .x = 0, .y = 0, .width = 1280, .height = 720 }, Color{}));
+    for (std::size_t i = 1; i < count_; i++)
+        widgets.push_back(Frame::create(widgets[(i - 1) / fan_out], get_child_rect(i),
+                                        Color{ .r = 0.5f, .g = 0.5f, .b = 0.5f, .a = 1.0f }));
+    return widgets;
+}
+
+}
+
+
+
+int main(int argc, char** argv)
+{
+    std::size_t node_count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 100;
+
+    std::cout << node_count << " nodes, fan out " << fan_out << ", " << iterations << " iterations\n";
+
+    auto build_start = Clock::now();
+    auto widgets = build_widgets(node_count);
+    auto& root = *widgets.front();
+    std::cout << "build: " << to_ms(Clock::now() - build_start) << " ms\n";
+
+    DamageRegion damage;
+    root.update(damage);
+
+    // moving the root makes every world rect stale
+
+    double full = measure(iterations, [&](int i_)
+        {
+            root.set_rect(Rect{ .x = i_ % 2, .y = 0, .width = 1280, .height = 720 });
+            damage.clear();
+            root.update(damage);
+        });
+    std::cout << "full update, widget storage: " << full << " ms\n";
+
+    for (bool is_shuffled : { false, true })
+    {
+        auto nodes = allocate_nodes(node_count, is_shuffled);
+        double pointers = measure(iterations, [&](int i_)
+            {
+                update_nodes(*nodes.front(), Point{ .x = i_ % 2, .y = 0 });
+            });
+        std::cout << "full update, allocated nodes" << (is_shuffled ? " in random order: " : ": ")
+                  << pointers << " ms\n";
+    }
+
+    // moving one leaf only walks the path down to it
+
+    std::mt19937 random{ 7 };
+    double incremental = measure(iterations, [&](int i_)
+        {
+            auto& leaf = *widgets[node_count - 1 - random() % (node_count / 2)];
+            leaf.set_rect(get_child_rect(static_cast<std::size_t>(i_)));
+            damage.clear();
+            root.update(damage);
+        });
+    std::cout << "update after moving one leaf: " << incremental << " ms\n";
+
+    // reparenting breaks the depth-first order, so the next update sorts the tables again
+
+    double reparent = measure(std::max(iterations / 10, 1), [&](int)
+        {
+            for (int j = 0; j < 100; j++)
+            {
+                auto& leaf = widgets[node_count - 1 - random() % (node_count / 2)];
+                widgets[random() % (node_count / fan_out)]->add_child(leaf);
+            }
+            damage.clear();
+            root.update(damage);
+        });
+    std::cout << "update after moving 100 leaves to other parents: " << reparent << " ms\n";
+
+    return 0;
+}
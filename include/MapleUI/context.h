@@ -1,5 +1,12 @@
 #pragma once
 #include "define.h"
+#include "painter.h"
+#include "frame_scheduler.h"
+#include "triple_buffer.h"
+#include "instrumentation.h"
+#include "input.h"
+#include "job_system.h"
+#include "widget/object.h"
 
 
 
@@ -13,23 +20,72 @@ namespace maple
 // ====================================================================================================================
 
 //
-// 
+// Settings that apply to every Window of a Context.
+// shader_cache_directory enables the on-disk program binary cache when it is not empty.
+// A headless Context needs no display: it uses a surfaceless EGL context, and its windows
+// render into framebuffer objects that can be read back with Window::read_pixels.
+// With a render thread, mainloop keeps handling events and running paint callbacks on the calling thread,
+// while every OpenGL call moves to a thread that owns the contexts.
+// worker_count is the number of threads of the JobSystem of the Context, which help the thread running mainloop.
+// When it is not set, there is one worker less than there are cores.
+//
+struct ContextProperties
+{
+    std::filesystem::path shader_cache_directory;
+    bool is_headless{ false };
+    bool is_render_thread_enabled{ false };
+    std::optional<std::size_t> worker_count{};
+};
+
+//
+// Windows are only drawn when they were invalidated since their last frame.
+// A window that is visited by draw without being invalidated, or whose damage lies entirely outside
+// its framebuffer, counts as a skipped frame.
+// Between frames mainloop sleeps until the next event or the next deadline of the FrameScheduler.
+// While readbacks or fences of earlier frames are outstanding, it also wakes every poll interval to collect them;
+// such passes count neither as drawn nor as skipped frames.
+// Builds with MAPLE_ENABLE_INSTRUMENTATION record the time of every frame phase into the FrameTimeline.
 //
 class Window;
 class Context
 {
 public:
+    static std::shared_ptr<Context> create(const ContextProperties& props_);
     static std::shared_ptr<Context> create();
 
+public:
+    struct Statistics
+    {
+        std::size_t drawn_frames{ 0 };
+        std::size_t skipped_frames{ 0 };
+    };
+
     bool mainloop();
+    void draw();
+
+    FrameScheduler& get_scheduler();
+    FrameTimeline& get_frame_timeline();
+    JobSystem& get_job_system();
+    const Statistics& get_statistics() const;
 
 private:
     struct InternalData;
+    struct RenderSnapshot;
 
-    Context();
+    Context(const ContextProperties& props_);
     virtual ~Context();
 
+    void p_close_windows();
+    void p_dispatch_input();
+
+    void p_start_render_thread();
+    void p_stop_render_thread();
+    void p_publish_frame();
+    void p_render_thread_main();
+
+    ContextProperties m_prop;
     std::shared_ptr<InternalData> m_internal;
+    Statistics m_statistics;
 
     friend class Window;
 };
@@ -40,11 +96,17 @@ private:
 //      CLASS: Window
 // ====================================================================================================================
 
+//
+// swap_interval is the number of vertical blanks a swap waits for. When it is not set, the Context picks one:
+// in every pass only the last such window drawn waits for vertical blank and every other window swaps
+// immediately, so that drawing several windows per frame does not divide the frame rate by the number of windows.
+//
 struct WindowProperties
 {
     Size size;
     Point position;
     std::string title;
+    std::optional<int> swap_interval{};
 };
 
 class Window
@@ -57,16 +119,52 @@ public:
                                           const std::string& title_);
     static std::shared_ptr<Window> create(std::shared_ptr<Context>& context_);
 
+    std::shared_ptr<maple::Frame> get_root() const;
+
+    void on_paint(event_type::WindowPaint callback_);
+    void on_close_attempt(event_type::WindowCloseAttempt callback_);
+    Signal<void()>::Connection on_close(event_type::WindowClose callback_);
+    void disconnect_close(Signal<void()>::Connection connection_);
+    Signal<void(const InputEvent&)>::Connection on_input(event_type::WindowInput callback_);
+    void disconnect_input(Signal<void(const InputEvent&)>::Connection connection_);
+
+    void post_input(const InputEvent& event_);
+    std::span<const InputEvent> get_input_history(const InputEvent& event_) const;
+    InputLatency get_input_latency() const;
+    void reset_input_latency();
+
+    void invalidate();
+    void invalidate(const Rect& rect_);
+    void close();
+
+    Size get_framebuffer_size() const;
+    std::vector<std::uint8_t> read_pixels();
+    void capture(event_type::WindowCapture callback_);
+
 private:
     struct InternalData;
+    struct Frame;
 
     Window(std::shared_ptr<Context>& context_, const WindowProperties& props_);
     virtual ~Window();
 
     void p_show();
-    void p_draw();
+    Frame& p_get_frame();
+    void p_draw(FrameRecord& record_);
+    bool p_record(Frame& frame_);
+    void p_render(Frame& frame_);
+    void p_deliver_captures();
+    void p_dispatch_input();
+#ifdef MAPLE_ENABLE_INSTRUMENTATION
+    void p_collect_gpu_times();
+    void p_collect_input_latency();
+#endif
     void p_close();
     bool p_is_close_approved();
+    bool p_is_invalidated() const;
+    bool p_is_polling() const;
+    std::uint64_t p_get_generation() const;
+    void p_set_generation(std::uint64_t generation_);
 
     WindowProperties m_prop;
     std::shared_ptr<InternalData> m_internal;
@@ -0,0 +1,44 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: DamageRegion
+// ====================================================================================================================
+
+//
+// The parts of a window that have to be redrawn, as a small set of non-overlapping rectangles.
+// Rectangles that overlap, or whose bounding box covers no more pixels than the rectangles themselves,
+// are merged on add. Beyond max_rect_count the pair whose bounding box wastes the fewest pixels is merged,
+// so every rectangle can be drawn under its own scissor without growing the number of passes.
+// Coordinates are in framebuffer pixels with the origin at the top left corner.
+//
+class DamageRegion
+{
+public:
+    static constexpr std::size_t max_rect_count = 4;
+
+    void add(const Rect& rect_);
+    void add_all();
+    void clip(const Size& bounds_);
+    void clear();
+
+    bool is_empty() const;
+    bool intersects(const Rect& rect_) const;
+
+    const std::vector<Rect>& get_rects() const;
+
+private:
+    std::vector<Rect> m_rects;
+    bool m_is_all{ false };
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
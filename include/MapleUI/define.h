@@ -1,17 +1,38 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <array>
+#include <span>
 #include <vector>
+#include <deque>
+#include <algorithm>
+
+#include <cstddef>
+#include <cstdint>
 
 #include <exception>
 #include <stdexcept>
 
 #include <memory>
+#include <filesystem>
 #include <functional>
 #include <utility>
+#include <new>
+#include <type_traits>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #include <iostream>
+#include <fstream>
+#include <cstdio>
 
 
 #ifndef out
@@ -22,19 +43,18 @@
 namespace maple
 {
 
+    class Painter;
+    struct Image;
+    struct InputEvent;
+
     namespace configuration
     {
 
         inline constexpr int opengl_version_major = 4;
         inline constexpr int opengl_version_minor = 5;
 
-    }
-
-    namespace event_type
-    {
-
-        using WindowCloseAttempt    = std::function<bool()>;
-        using WindowClose           = std::function<void()>;
+        // how often mainloop wakes to collect GPU results that are still on their way
+        inline constexpr std::chrono::milliseconds poll_interval{ 1 };
 
     }
 
@@ -50,4 +70,32 @@ namespace maple
         int height{ 0 };
     };
 
-}
\ No newline at end of file
+    struct Rect
+    {
+        int x{ 0 };
+        int y{ 0 };
+        int width{ 0 };
+        int height{ 0 };
+    };
+
+    struct Color
+    {
+        float r{ 0.0f };
+        float g{ 0.0f };
+        float b{ 0.0f };
+        float a{ 1.0f };
+    };
+
+    //
+    // RGBA pixels with 8 bits per channel, rows from top to bottom.
+    //
+    struct Image
+    {
+        Size size{};
+        std::vector<std::uint8_t> pixels{};
+    };
+
+}
+
+// the event types in maple::event_type are delegates
+#include "delegate.h"
@@ -0,0 +1,377 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: Delegate
+// ====================================================================================================================
+
+//
+// Move-only replacement for std::function. Callables up to InlineSize bytes that can be moved without throwing
+// are stored inside the delegate, so typical lambdas capturing a few pointers never allocate.
+// Larger callables are moved to the heap. Calling goes through one function pointer, like a virtual call.
+//
+template <typename Signature, std::size_t InlineSize = 4 * sizeof(void*)>
+class Delegate;
+
+template <typename R, typename... Args, std::size_t InlineSize>
+class Delegate<R(Args...), InlineSize>
+{
+public:
+    Delegate() = default;
+    Delegate(std::nullptr_t);
+
+    template <typename F>
+        requires (!std::is_same_v<std::remove_cvref_t<F>, Delegate> && std::is_invocable_r_v<R, F&, Args...>)
+    Delegate(F&& function_);
+
+    Delegate(Delegate&& other_) noexcept;
+    Delegate& operator=(Delegate&& other_) noexcept;
+    Delegate& operator=(std::nullptr_t);
+    ~Delegate();
+
+    Delegate(const Delegate&) = delete;
+    Delegate& operator=(const Delegate&) = delete;
+
+    R operator()(Args... args_) const;
+    explicit operator bool() const;
+    bool is_inline() const;
+
+private:
+    struct Operations
+    {
+        R (*invoke)(void* storage_, Args&&... args_);
+        void (*move)(void* destination_, void* source_) noexcept;
+        void (*destroy)(void* storage_) noexcept;
+        bool is_inline;
+    };
+
+    template <typename F>
+    static constexpr bool fits_inline = sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t)
+                                     && std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    static const Operations* p_get_operations();
+
+    void p_reset();
+
+    alignas(std::max_align_t) mutable std::byte m_storage[InlineSize];
+    const Operations* m_operations{ nullptr };
+};
+
+
+
+// ====================================================================================================================
+//      CLASS: Signal
+// ====================================================================================================================
+
+//
+// Calls every connected slot in the order they were connected. Slots are stored contiguously.
+// Slots may connect and disconnect, including themselves, while the signal is emitted:
+// slots connected during an emit are first called by the next emit, and disconnected slots
+// are no longer called, but are only destroyed once the outermost emit returns.
+//
+template <typename Signature>
+class Signal;
+
+template <typename... Args>
+class Signal<void(Args...)>
+{
+public:
+    using Slot = Delegate<void(Args...)>;
+    using Connection = std::uint64_t;
+
+    Connection connect(Slot slot_);
+    void disconnect(Connection connection_);
+    void clear();
+
+    void emit(Args... args_);
+
+    std::size_t get_slot_count() const;
+    bool is_empty() const;
+
+private:
+    struct Entry
+    {
+        Connection connection{ 0 };
+        Slot slot{};
+    };
+
+    //
+    // Counts a running emit, and merges the slots connected meanwhile once the outermost one returns,
+    // also when a slot throws.
+    //
+    class EmitGuard
+    {
+    public:
+        EmitGuard(Signal& signal_);
+        ~EmitGuard();
+
+        EmitGuard(const EmitGuard&) = delete;
+        EmitGuard& operator=(const EmitGuard&) = delete;
+
+    private:
+        Signal& m_signal;
+    };
+
+    void p_compact();
+
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_connected_while_emitting;
+    Connection m_next_connection{ 1 };
+    int m_emit_depth{ 0 };
+    bool m_has_disconnected{ false };
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+namespace event_type
+{
+
+    using WindowCloseAttempt    = Delegate<bool()>;
+    using WindowClose           = Delegate<void()>;
+    using WindowPaint           = Delegate<void(Painter&)>;
+    using WindowCapture         = Delegate<void(const Image&)>;
+    using WindowInput           = Delegate<void(const InputEvent&)>;
+    using Timer                 = Delegate<void()>;
+    using Animation             = Delegate<void(float)>;
+
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+template <typename R, typename... Args, std::size_t InlineSize>
+Delegate<R(Args...), InlineSize>::Delegate(std::nullptr_t)
+{
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+template <typename F>
+    requires (!std::is_same_v<std::remove_cvref_t<F>, Delegate<R(Args...), InlineSize>>
+              && std::is_invocable_r_v<R, F&, Args...>)
+Delegate<R(Args...), InlineSize>::Delegate(F&& function_)
+{
+    using Callable = std::decay_t<F>;
+
+    if constexpr (std::is_pointer_v<Callable> || std::is_member_pointer_v<Callable>)
+        if (!function_)
+            return;
+
+    if constexpr (fits_inline<Callable>)
+        ::new (static_cast<void*>(m_storage)) Callable(std::forward<F>(function_));
+    else
+        ::new (static_cast<void*>(m_storage)) Callable*(new Callable(std::forward<F>(function_)));
+    m_operations = p_get_operations<Callable>();
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+Delegate<R(Args...), InlineSize>::Delegate(Delegate&& other_) noexcept
+{
+    if (!other_.m_operations)
+        return;
+
+    other_.m_operations->move(m_storage, other_.m_storage);
+    m_operations = std::exchange(other_.m_operations, nullptr);
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+Delegate<R(Args...), InlineSize>& Delegate<R(Args...), InlineSize>::operator=(Delegate&& other_) noexcept
+{
+    if (this == &other_)
+        return *this;
+
+    p_reset();
+    if (other_.m_operations)
+    {
+        other_.m_operations->move(m_storage, other_.m_storage);
+        m_operations = std::exchange(other_.m_operations, nullptr);
+    }
+    return *this;
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+Delegate<R(Args...), InlineSize>& Delegate<R(Args...), InlineSize>::operator=(std::nullptr_t)
+{
+    p_reset();
+    return *this;
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+Delegate<R(Args...), InlineSize>::~Delegate()
+{
+    p_reset();
+}
+
+//
+// Like std::function, calling is const even though the callable may change its own state.
+//
+template <typename R, typename... Args, std::size_t InlineSize>
+R Delegate<R(Args...), InlineSize>::operator()(Args... args_) const
+{
+    if (!m_operations)
+        throw std::runtime_error("R Delegate::operator()(Args...): The delegate is empty.");
+
+    return m_operations->invoke(m_storage, std::forward<Args>(args_)...);
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+Delegate<R(Args...), InlineSize>::operator bool() const
+{
+    return m_operations != nullptr;
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+bool Delegate<R(Args...), InlineSize>::is_inline() const
+{
+    return m_operations && m_operations->is_inline;
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+template <typename F>
+const typename Delegate<R(Args...), InlineSize>::Operations* Delegate<R(Args...), InlineSize>::p_get_operations()
+{
+    static constexpr Operations operations = []
+        {
+            if constexpr (fits_inline<F>)
+                return Operations{
+                    .invoke  = [](void* storage_, Args&&... args_) -> R
+                        {
+                            return std::invoke(*static_cast<F*>(storage_), std::forward<Args>(args_)...);
+                        },
+                    .move    = [](void* destination_, void* source_) noexcept
+                        {
+                            ::new (destination_) F(std::move(*static_cast<F*>(source_)));
+                            static_cast<F*>(source_)->~F();
+                        },
+                    .destroy = [](void* storage_) noexcept { static_cast<F*>(storage_)->~F(); },
+                    .is_inline = true
+                };
+            else
+                return Operations{
+                    .invoke  = [](void* storage_, Args&&... args_) -> R
+                        {
+                            return std::invoke(**static_cast<F**>(storage_), std::forward<Args>(args_)...);
+                        },
+                    .move    = [](void* destination_, void* source_) noexcept
+                        {
+                            ::new (destination_) F*(*static_cast<F**>(source_));
+                        },
+                    .destroy = [](void* storage_) noexcept { delete *static_cast<F**>(storage_); },
+                    .is_inline = false
+                };
+        }();
+
+    return &operations;
+}
+
+template <typename R, typename... Args, std::size_t InlineSize>
+void Delegate<R(Args...), InlineSize>::p_reset()
+{
+    if (m_operations)
+        std::exchange(m_operations, nullptr)->destroy(m_storage);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+template <typename... Args>
+typename Signal<void(Args...)>::Connection Signal<void(Args...)>::connect(Slot slot_)
+{
+    Connection connection = m_next_connection++;
+
+    // growing the vector would move a slot that is running, so new slots wait until the emit returns
+    auto& entries = m_emit_depth > 0 ? m_connected_while_emitting : m_entries;
+    entries.push_back(Entry{ .connection = connection, .slot = std::move(slot_) });
+    return connection;
+}
+
+template <typename... Args>
+void Signal<void(Args...)>::disconnect(Connection connection_)
+{
+    for (auto* entries : { &m_entries, &m_connected_while_emitting })
+        for (auto& entry : *entries)
+            if (entry.connection == connection_)
+                entry.connection = 0;
+
+    m_has_disconnected = true;
+    if (m_emit_depth == 0)
+        p_compact();
+}
+
+template <typename... Args>
+void Signal<void(Args...)>::clear()
+{
+    for (auto* entries : { &m_entries, &m_connected_while_emitting })
+        for (auto& entry : *entries)
+            entry.connection = 0;
+
+    m_has_disconnected = true;
+    if (m_emit_depth == 0)
+        p_compact();
+}
+
+//
+// Arguments are passed to every slot as lvalues, so a slot cannot move from them.
+// An exception thrown by a slot skips the remaining slots and propagates to the caller.
+//
+template <typename... Args>
+void Signal<void(Args...)>::emit(Args... args_)
+{
+    EmitGuard guard(*this);
+    std::size_t count = m_entries.size();
+    for (std::size_t i = 0; i < count; i++)
+        if (m_entries[i].connection != 0)
+            m_entries[i].slot(args_...);
+}
+
+template <typename... Args>
+std::size_t Signal<void(Args...)>::get_slot_count() const
+{
+    auto is_connected = [](const Entry& entry_) { return entry_.connection != 0; };
+    return std::ranges::count_if(m_entries, is_connected) + std::ranges::count_if(m_connected_while_emitting, is_connected);
+}
+
+template <typename... Args>
+bool Signal<void(Args...)>::is_empty() const
+{
+    return get_slot_count() == 0;
+}
+
+template <typename... Args>
+Signal<void(Args...)>::EmitGuard::EmitGuard(Signal& signal_)
+    : m_signal{ signal_ }
+{
+    m_signal.m_emit_depth++;
+}
+
+template <typename... Args>
+Signal<void(Args...)>::EmitGuard::~EmitGuard()
+{
+    m_signal.m_emit_depth--;
+    if (m_signal.m_emit_depth == 0)
+        m_signal.p_compact();
+}
+
+template <typename... Args>
+void Signal<void(Args...)>::p_compact()
+{
+    if (m_has_disconnected)
+    {
+        std::erase_if(m_entries, [](const Entry& entry_) { return entry_.connection == 0; });
+        m_has_disconnected = false;
+    }
+
+    for (auto& entry : m_connected_while_emitting)
+        if (entry.connection != 0)
+            m_entries.push_back(std::move(entry));
+    m_connected_while_emitting.clear();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: FrameScheduler
+// ====================================================================================================================
+
+//
+// Keeps the deadlines of timers and animations, so Context::mainloop can sleep until exactly the earliest one
+// instead of polling. Every deadline within the coalescing slack of the earliest one fires on the same wakeup.
+// Animations tick on a frame grid shared by the whole Context, so animations in different windows
+// wake the loop once per frame instead of once per animation.
+//
+class FrameScheduler
+{
+private:
+    FrameScheduler();
+    virtual ~FrameScheduler();
+public:
+    static std::shared_ptr<FrameScheduler> create();
+
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = std::uint64_t;
+
+    struct Statistics
+    {
+        std::size_t wakeups{ 0 };
+        std::size_t fired{ 0 };
+    };
+
+    TimerId add_timer(Clock::duration delay_, event_type::Timer callback_);
+    TimerId add_repeating_timer(Clock::duration interval_, event_type::Timer callback_);
+    TimerId add_animation(Clock::duration duration_, event_type::Animation callback_);
+    void cancel(TimerId id_);
+
+    void set_frame_interval(Clock::duration interval_);
+    void set_coalescing_slack(Clock::duration slack_);
+
+    std::optional<Clock::time_point> get_next_deadline();
+    std::size_t run_due(Clock::time_point now_);
+
+    const Statistics& get_statistics() const;
+
+private:
+    struct Timer
+    {
+        Clock::time_point deadline{};
+        Clock::duration interval{ 0 };
+        event_type::Timer callback{ nullptr };
+
+        Clock::time_point start{};
+        Clock::duration duration{ 0 };
+        event_type::Animation animation{ nullptr };
+    };
+
+    struct Deadline
+    {
+        Clock::time_point time{};
+        TimerId id{ 0 };
+    };
+
+    static bool p_is_later(const Deadline& a_, const Deadline& b_);
+
+    TimerId p_add(Timer timer_);
+    Clock::time_point p_next_frame(Clock::time_point after_) const;
+    void p_drop_cancelled();
+
+    std::unordered_map<TimerId, Timer> m_timers;
+    std::vector<Deadline> m_deadlines;
+    TimerId m_next_id;
+    TimerId m_firing;
+    bool m_is_firing_cancelled;
+
+    Clock::time_point m_epoch;
+    Clock::duration m_frame_interval;
+    Clock::duration m_slack;
+
+    Statistics m_statistics;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
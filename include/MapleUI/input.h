@@ -0,0 +1,78 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: InputQueue
+// ====================================================================================================================
+
+enum class InputEventType
+{
+    cursor_move,
+    scroll,
+    framebuffer_resize,
+    mouse_button,
+    key,
+    character
+};
+
+//
+// One input event of a window. Only the fields of its type are set:
+// x and y hold the cursor position in window coordinates for cursor_move, and the offset for scroll.
+// code is the mouse button for mouse_button and the key for key, and action and mods are the GLFW values.
+// A coalesced event stands for history_count raw events, starting at history_begin in the history of its queue,
+// and time is the time of the newest of them.
+//
+struct InputEvent
+{
+    using Clock = std::chrono::steady_clock;
+
+    InputEventType type{ InputEventType::cursor_move };
+    Clock::time_point time{};
+
+    double x{ 0.0 };
+    double y{ 0.0 };
+    Size size{};
+    int code{ 0 };
+    int scancode{ 0 };
+    int action{ 0 };
+    int mods{ 0 };
+    unsigned int codepoint{ 0 };
+
+    std::size_t history_begin{ 0 };
+    std::size_t history_count{ 1 };
+};
+
+//
+// Collects the input events of a window between two dispatches.
+// Consecutive cursor moves and framebuffer resizes are merged into the last of them, and consecutive scrolls
+// into their sum, so a high-rate mouse costs one event per frame. Any other event ends the run,
+// so a button press is never reordered with the moves around it.
+// Every raw event is kept in the history, for consumers such as drawing apps that want every sample.
+//
+class InputQueue
+{
+public:
+    void push(const InputEvent& event_);
+    void clear();
+
+    bool is_empty() const;
+
+    const std::vector<InputEvent>& get_events() const;
+    const std::vector<InputEvent>& get_history() const;
+    std::span<const InputEvent> get_history(const InputEvent& event_) const;
+
+private:
+    std::vector<InputEvent> m_events;
+    std::vector<InputEvent> m_history;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
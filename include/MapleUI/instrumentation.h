@@ -0,0 +1,180 @@
+#pragma once
+#include "define.h"
+
+//
+// MAPLE_INSTRUMENT(...) keeps its arguments only when MAPLE_ENABLE_INSTRUMENTATION is defined,
+// so every timing statement wrapped in it compiles to nothing in builds without instrumentation.
+//
+#ifdef MAPLE_ENABLE_INSTRUMENTATION
+    #define MAPLE_INSTRUMENT(...) __VA_ARGS__
+#else
+    #define MAPLE_INSTRUMENT(...)
+#endif
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: FrameRecord
+// ====================================================================================================================
+
+enum class FramePhase
+{
+    event_wait,
+    layout,
+    command_generation,
+    gpu_submit,
+    swap,
+    count
+};
+
+//
+// Render passes timed on the GPU in builds with instrumentation.
+//
+enum class GpuPass
+{
+    clear,
+    rects,
+    blit,
+    count
+};
+
+const char* to_string(FramePhase phase_);
+const char* to_string(GpuPass pass_);
+
+//
+// Time spent in every phase of one frame, summed over the windows drawn in it.
+// event_wait is the time mainloop slept before the frame, gpu_submit covers clearing, uploading and draw calls,
+// and swap covers presenting, which is where waiting for vertical blank or for the GPU shows up.
+// GPU times of the render passes arrive a few frames later, and stay zero if the record left the ring before.
+//
+struct FrameRecord
+{
+    using Phases = std::array<std::chrono::nanoseconds, static_cast<std::size_t>(FramePhase::count)>;
+    using GpuPasses = std::array<std::chrono::nanoseconds, static_cast<std::size_t>(GpuPass::count)>;
+
+    std::uint64_t frame{ 0 };
+    std::size_t window_count{ 0 };
+    std::size_t draw_calls{ 0 };
+    Phases phases{};
+    GpuPasses gpu_passes{};
+
+    void add(FramePhase phase_, std::chrono::nanoseconds duration_);
+    void add(GpuPass pass_, std::chrono::nanoseconds duration_);
+    void merge(const FrameRecord& other_);
+    std::chrono::nanoseconds get(FramePhase phase_) const;
+    std::chrono::nanoseconds get(GpuPass pass_) const;
+};
+
+//
+// Adds the time until it goes out of scope to one phase of a record.
+//
+class PhaseTimer
+{
+public:
+    PhaseTimer(FrameRecord& record_, FramePhase phase_);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    FrameRecord& m_record;
+    FramePhase m_phase;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+
+
+// ====================================================================================================================
+//      CLASS: FrameTimeline
+// ====================================================================================================================
+
+//
+// Fixed-size ring of the most recent frame records, numbered by the Context. Pushing never allocates.
+// Frames are pushed by whichever thread finishes them, so reading takes a copy under a lock held once per frame.
+// Stays empty unless the library was built with MAPLE_ENABLE_INSTRUMENTATION.
+//
+class FrameTimeline
+{
+private:
+    FrameTimeline(std::size_t capacity_);
+    virtual ~FrameTimeline();
+public:
+    static std::shared_ptr<FrameTimeline> create(std::size_t capacity_ = 240);
+
+public:
+    void push(const FrameRecord& record_);
+    void add_gpu_time(std::uint64_t frame_, GpuPass pass_, std::chrono::nanoseconds duration_);
+    void clear();
+
+    std::vector<FrameRecord> get_records() const;
+    std::size_t get_capacity() const;
+
+    void dump(std::ostream& stream_) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<FrameRecord> m_records;
+    std::size_t m_next;
+    std::size_t m_size;
+};
+
+
+
+// ====================================================================================================================
+//      CLASS: LatencyRecorder
+// ====================================================================================================================
+
+//
+// Nearest-rank percentiles of the samples a LatencyRecorder holds. All zero when it holds none.
+//
+struct LatencyPercentiles
+{
+    std::size_t count{ 0 };
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p90{};
+    std::chrono::nanoseconds p99{};
+    std::chrono::nanoseconds max{};
+};
+
+//
+// How long the input of a window took to show. swap is measured from the input callback until the swap
+// of the first frame drawn after the input invalidated the window, gpu until a fence behind that swap signaled.
+// The GPU time is an upper bound by up to configuration::poll_interval, since outstanding fences are polled
+// that often, and when the window draws.
+//
+struct InputLatency
+{
+    LatencyPercentiles swap{};
+    LatencyPercentiles gpu{};
+};
+
+//
+// Keeps the most recent samples in a fixed-size ring, so recording never allocates.
+// Samples are added by the thread drawing a window and read by the thread handling its events.
+//
+class LatencyRecorder
+{
+public:
+    LatencyRecorder(std::size_t capacity_ = 512);
+
+    void add(std::chrono::nanoseconds latency_);
+    void clear();
+
+    LatencyPercentiles get_percentiles() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::chrono::nanoseconds> m_samples;
+    std::size_t m_next;
+    std::size_t m_size;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: JobSystem
+// ====================================================================================================================
+
+//
+// Worker threads that run jobs, each with its own deque. A thread pushes the jobs it queues to the back
+// of its own deque and takes them back from there, so nested forks stay on the thread that made them,
+// while idle workers steal the oldest, and usually largest, jobs from the front of the other deques.
+// Threads outside the system, such as the one running mainloop, share one more deque.
+// Jobs come in two kinds. Jobs run for a JobGroup are fork-join tasks, cheap enough to split a loop with.
+// Jobs submitted on their own get a handle, and may depend on other handles: they are only queued
+// once every job they depend on finished, whether it succeeded or threw.
+// Waiting for a group or a job runs queued jobs, of any kind, until it is done, and only sleeps once
+// there is nothing left to take. A job may therefore wait for the groups it forked and for jobs it submitted,
+// and the thread running mainloop can wait for jobs even on a system without workers, where everything
+// runs in wait. The price is that a waiting thread may pick up an unrelated long job, so jobs are meant to be short.
+// A job picked up while waiting runs on top of the waiting job, which cannot resume before it returns.
+// A job must therefore never wait for a job that is, or may be, waiting further down the same stack:
+// if a thread waiting within job A picks up job C, and C waits for A, neither ever finishes.
+// Express such orderings as dependencies of submit instead, which never block a thread.
+// Every worker counts the jobs it ran and stole and the time it spent running them.
+// The threads outside the system share one more set of counters, which shows how much they helped while waiting.
+//
+class JobSystem
+{
+private:
+    JobSystem(std::size_t worker_count_);
+    virtual ~JobSystem();
+public:
+    static std::shared_ptr<JobSystem> create(std::size_t worker_count_);
+
+public:
+    class Job;
+    using JobHandle = std::shared_ptr<Job>;
+
+    //
+    // The jobs forked for one join. The first exception thrown by any of them is rethrown by wait.
+    //
+    class JobGroup
+    {
+    public:
+        JobGroup();
+        ~JobGroup();
+
+        JobGroup(const JobGroup&) = delete;
+        JobGroup& operator=(const JobGroup&) = delete;
+
+    private:
+        std::atomic<std::size_t> m_pending;
+        std::mutex m_exception_mutex;
+        std::exception_ptr m_exception;
+
+        friend class JobSystem;
+    };
+
+    //
+    // utilization is the share of the time since the last reset that the thread spent running jobs.
+    //
+    struct WorkerStatistics
+    {
+        std::size_t executed_jobs{ 0 };
+        std::size_t stolen_jobs{ 0 };
+        std::chrono::nanoseconds busy_time{ 0 };
+        double utilization{ 0.0 };
+    };
+
+    void run(JobGroup& group_, std::function<void()> function_);
+    void wait(JobGroup& group_);
+
+    JobHandle submit(std::function<void()> function_, std::span<const JobHandle> dependencies_ = {});
+    void wait(const JobHandle& job_);
+    bool is_done(const JobHandle& job_) const;
+
+    std::size_t get_worker_count() const;
+    std::vector<WorkerStatistics> get_worker_statistics() const;
+    void reset_worker_statistics();
+
+private:
+    struct Task
+    {
+        std::function<void()> function{ nullptr };
+        JobGroup* group{ nullptr };
+        JobHandle job{ nullptr };
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // written by one worker, or by every thread outside the system, so each set has its own cache line
+    struct alignas(64) Counters
+    {
+        std::atomic<std::size_t> executed_jobs{ 0 };
+        std::atomic<std::size_t> stolen_jobs{ 0 };
+        std::atomic<std::int64_t> busy_nanoseconds{ 0 };
+    };
+
+    std::size_t p_get_queue_index() const;
+    void p_push(Task task_);
+    bool p_take(std::size_t index_, Task& task_);
+    void p_execute(std::size_t index_, Task& task_);
+    template <typename Predicate>
+    void p_wait_until(Predicate is_done_);
+    void p_finish(const JobHandle& job_);
+    void p_notify_waiters();
+    void p_worker_main(std::size_t index_);
+
+    // one per worker, then the one shared by threads outside the system, for both
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::unique_ptr<Counters>> m_counters;
+    std::vector<std::thread> m_workers;
+
+    // workers sleep on m_wake, waiting threads that found nothing to take on m_waiter_wake;
+    // sleepers count themselves, so pushing and finishing only take the lock when someone sleeps
+    std::atomic<std::size_t> m_queued_count;
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_waiter_wake;
+    std::atomic<std::size_t> m_sleeping_workers;
+    std::atomic<std::size_t> m_sleeping_waiters;
+    bool m_is_stopping;
+
+    std::atomic<std::chrono::steady_clock::rep> m_statistics_start;
+};
+
+//
+// A job submitted on its own, only used through its handle. Dependents are queued by whichever thread finishes it.
+//
+class JobSystem::Job
+{
+private:
+    std::function<void()> m_function{ nullptr };
+
+    // one more while submitting, so a dependency finishing meanwhile cannot queue the job early
+    std::atomic<std::size_t> m_unfinished_dependencies{ 1 };
+
+    // m_is_done only changes under the mutex, so a dependent either registers before or sees it done
+    std::mutex m_mutex;
+    std::vector<JobHandle> m_dependents;
+    std::atomic<bool> m_is_done{ false };
+    std::exception_ptr m_exception{ nullptr };
+
+    friend class JobSystem;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "define.h"
+
+namespace maple
+{
+namespace gl
+{
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+//
+// Tells when the GPU finished the commands submitted before each fence, without waiting for it.
+// collect only polls, so the time of a fence is when collect first saw it signaled, which is
+// an upper bound of the completion that is as tight as collect is called often.
+// Fences belong to the context they were inserted in, so every context needs its own tracker.
+//
+class FenceTracker
+{
+private:
+    FenceTracker();
+    virtual ~FenceTracker();
+public:
+    static std::shared_ptr<FenceTracker> create();
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Result
+    {
+        std::uint64_t id{ 0 };
+        Clock::time_point time{};
+    };
+
+    void insert(std::uint64_t id_);
+    std::size_t collect(std::vector<Result>& results_);
+    bool is_pending() const;
+
+private:
+    struct Fence
+    {
+        std::uint64_t id{ 0 };
+        void* sync{ nullptr };
+    };
+
+    std::vector<Fence> m_fences;
+};
+
+
+}
+}
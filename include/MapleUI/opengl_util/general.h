@@ -6,6 +6,8 @@ namespace maple
 namespace gl
 {
 
+class ProgramBinaryCache;
+
 // ====================================================================================================================
 // 
 // ====================================================================================================================
@@ -27,6 +29,67 @@ private:
     unsigned int m_id;
 };
 
+//
+// Buffer for vertex or instance data that is rewritten every frame.
+// Backed by immutable storage that stays persistently and coherently mapped, split into regions that are used
+// as a ring. fence() marks the end of the draws reading the regions written since the previous fence,
+// and a region is only written again once the GPU has passed all of its fences.
+// Fences are shared objects, so draws from different OpenGL contexts of a share group may use the same buffer.
+//
+class StreamBuffer
+{
+private:
+    StreamBuffer(std::size_t region_size_, unsigned int region_count_);
+    virtual ~StreamBuffer();
+public:
+    static std::shared_ptr<StreamBuffer> create(std::size_t region_size_, unsigned int region_count_ = 3);
+
+public:
+    struct Allocation
+    {
+        void* data{ nullptr };
+        std::size_t offset{ 0 };
+    };
+
+    struct Statistics
+    {
+        std::size_t allocations{ 0 };
+        std::size_t stalls{ 0 };
+        std::size_t reallocations{ 0 };
+    };
+
+    void bind();
+    void unbind();
+    unsigned int get_id();
+
+    Allocation allocate(std::size_t size_, std::size_t alignment_);
+    void fence();
+
+    std::size_t get_region_size() const;
+    const Statistics& get_statistics() const;
+
+private:
+    struct Region
+    {
+        std::vector<void*> fences;
+        bool is_written{ false };
+    };
+
+    void p_create_storage();
+    void p_destroy_storage();
+    void p_wait(Region& region_);
+
+    unsigned int m_id;
+    std::byte* m_mapped;
+
+    std::size_t m_region_size;
+    std::vector<Region> m_regions;
+    std::size_t m_current_region;
+    std::size_t m_region_offset;
+
+    Statistics m_statistics;
+};
+
 class VertexArray
 {
 private:
@@ -45,27 +108,142 @@ private:
 };
 
 
+//
+// Framebuffer object with a single RGBA8 color texture.
+// Framebuffer objects are not shared between OpenGL contexts, so it must only be used in the context that created it.
+//
+class Framebuffer
+{
+private:
+    Framebuffer(const Size& size_);
+    virtual ~Framebuffer();
+public:
+    static std::shared_ptr<Framebuffer> create(const Size& size_);
+
+public:
+    void bind();
+    void unbind();
+    unsigned int get_id();
+    unsigned int get_color_texture();
+
+    Size get_size() const;
+    void resize(const Size& size_);
+
+private:
+    void p_create_attachments();
+
+    unsigned int m_id;
+    unsigned int m_color_texture;
+    Size m_size;
+};
+
+
 // ====================================================================================================================
 // 
 // ====================================================================================================================
 
+//
+// Location of an active uniform, looked up once with Shader::get_uniform and reused every frame.
+// Setting an invalid handle is silently ignored by OpenGL, like setting a uniform that was optimized out.
+//
+struct UniformHandle
+{
+    int location{ -1 };
+
+    bool is_valid() const { return location >= 0; }
+};
+
+//
+// All active uniforms are reflected once after linking into a flat table sorted by name,
+// so looking up a handle never queries the driver.
+// With a ProgramBinaryCache the linked binary is loaded from disk when possible,
+// and compiling from source is the fallback on a miss or when the driver rejects the binary.
+// The setters use glProgramUniform*, so the shader does not need to be bound.
+//
 class Shader
 {
 private:
-    Shader(const std::string& vertex_, const std::string& fragment_);
+    Shader(const std::string& vertex_, const std::string& fragment_,
+           const std::shared_ptr<ProgramBinaryCache>& cache_);
     virtual ~Shader();
 public:
-    static std::shared_ptr<Shader> create(const std::string& vertex_, const std::string& fragment_);
+    static std::shared_ptr<Shader> create(const std::string& vertex_, const std::string& fragment_,
+                                          const std::shared_ptr<ProgramBinaryCache>& cache_ = nullptr);
 
 public:
+    struct Uniform
+    {
+        std::string name;
+        int location{ -1 };
+        unsigned int type{ 0 };
+        int array_size{ 1 };
+    };
+
     void bind();
     void unbind();
     unsigned int get_id();
 
+    UniformHandle get_uniform(std::string_view name_) const;
+    const std::vector<Uniform>& get_uniforms() const;
+
+    void set_uniform_int(UniformHandle handle_, int value_);
+    void set_uniform_vec2(UniformHandle handle_, float x_, float y_);
+    void set_uniform_vec4(UniformHandle handle_, float x_, float y_, float z_, float w_);
+    void set_uniform_mat3(UniformHandle handle_, const float* column_major_);
+
+    void set_uniform_int_array(UniformHandle handle_, const int* values_, int count_);
+    void set_uniform_vec2_array(UniformHandle handle_, const float* values_, int count_);
+    void set_uniform_vec4_array(UniformHandle handle_, const float* values_, int count_);
+    void set_uniform_mat3_array(UniformHandle handle_, const float* column_major_, int count_);
+
+    void set_uniform_vec2(const std::string& name_, float x_, float y_);
     void set_uniform_vec4(const std::string& name_, float r_, float g_, float b_, float a_);
 
 private:
+    Shader(unsigned int program_);
+    static std::shared_ptr<Shader> p_create(unsigned int program_);
+
+    void p_reflect_uniforms();
+
     unsigned int m_id;
+    std::vector<Uniform> m_uniforms;
+
+    friend class ShaderFuture;
+};
+
+//
+// Starts compiling and linking a shader without waiting for the driver to finish,
+// so many programs can be started at once and compiled in parallel by the driver.
+// With GL_KHR_parallel_shader_compile (or the ARB variant) is_ready polls GL_COMPLETION_STATUS_KHR
+// and never blocks. Without it is_ready always returns true, and get blocks until the program is linked.
+// get hands back the finished Shader; the future must be used with the OpenGL context (or share group)
+// it was created in.
+//
+class ShaderFuture
+{
+private:
+    ShaderFuture(const std::string& vertex_, const std::string& fragment_,
+                 const std::shared_ptr<ProgramBinaryCache>& cache_);
+    virtual ~ShaderFuture();
+public:
+    static std::shared_ptr<ShaderFuture> create(const std::string& vertex_, const std::string& fragment_,
+                                                const std::shared_ptr<ProgramBinaryCache>& cache_ = nullptr);
+
+    static bool is_parallel_compile_supported();
+
+public:
+    bool is_ready();
+    std::shared_ptr<Shader> get();
+
+private:
+    unsigned int m_program;
+    unsigned int m_vertex_shader;
+    unsigned int m_fragment_shader;
+
+    std::shared_ptr<ProgramBinaryCache> m_cache;
+    std::string m_key;
+
+    std::shared_ptr<Shader> m_shader;
 };
 
 
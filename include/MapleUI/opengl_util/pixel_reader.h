@@ -0,0 +1,63 @@
+#pragma once
+#include "define.h"
+
+namespace maple
+{
+namespace gl
+{
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+//
+// Reads framebuffers back through pixel buffer objects, without waiting for the GPU.
+// read only queues the copy and a fence. collect maps the buffers whose fence has signaled,
+// so the pixels of a frame are usually available one or two frames later.
+// Buffers are reused once collected, and more are created while every buffer is still in flight.
+// Buffers are not shared between OpenGL contexts, so every context needs its own reader.
+//
+class PixelReader
+{
+private:
+    PixelReader();
+    virtual ~PixelReader();
+public:
+    static std::shared_ptr<PixelReader> create();
+
+public:
+    struct Statistics
+    {
+        std::size_t reads{ 0 };
+        std::size_t buffers{ 0 };
+    };
+
+    void read(unsigned int framebuffer_, const Size& size_);
+    std::size_t collect(std::vector<Image>& images_);
+    bool is_pending() const;
+
+    const Statistics& get_statistics() const;
+
+private:
+    struct Buffer
+    {
+        unsigned int id{ 0 };
+        std::size_t capacity{ 0 };
+    };
+
+    struct Request
+    {
+        Buffer buffer{};
+        Size size{};
+        void* fence{ nullptr };
+    };
+
+    std::vector<Buffer> m_free_buffers;
+    std::vector<Request> m_requests;
+
+    Statistics m_statistics;
+};
+
+
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "define.h"
+
+namespace maple
+{
+namespace gl
+{
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+//
+// Stores linked program binaries on disk, so the next run can skip compiling shaders from source.
+// Binaries are keyed by a hash of the shader sources together with the GL_RENDERER and GL_VERSION strings,
+// since a binary is only valid for the driver that produced it.
+// Must be created while an OpenGL context is current. If the driver supports no binary formats
+// or the directory cannot be created, the cache stays disabled and every lookup misses.
+//
+class ProgramBinaryCache
+{
+private:
+    ProgramBinaryCache(const std::filesystem::path& directory_);
+    virtual ~ProgramBinaryCache();
+public:
+    static std::shared_ptr<ProgramBinaryCache> create(const std::filesystem::path& directory_);
+
+public:
+    struct Statistics
+    {
+        std::size_t hits{ 0 };
+        std::size_t misses{ 0 };
+        std::size_t rejected{ 0 };
+        std::size_t stored{ 0 };
+    };
+
+    bool is_enabled() const;
+
+    std::string make_key(const std::string& vertex_, const std::string& fragment_) const;
+
+    bool load(unsigned int program_, const std::string& key_);
+    void store(unsigned int program_, const std::string& key_);
+
+    const Statistics& get_statistics() const;
+
+private:
+    std::filesystem::path p_get_path(const std::string& key_) const;
+
+    std::filesystem::path m_directory;
+    std::string m_driver;
+    bool m_is_enabled;
+
+    Statistics m_statistics;
+};
+
+
+}
+}
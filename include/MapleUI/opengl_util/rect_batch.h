@@ -0,0 +1,111 @@
+#pragma once
+#include "define.h"
+
+namespace maple
+{
+namespace gl
+{
+
+class Shader;
+class StreamBuffer;
+class VertexArray;
+struct UniformHandle;
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+//
+// Per-instance data of a single rectangle, in framebuffer pixels with the origin at the top left corner.
+// The layout matches the vertex attributes configured by RectBatch::setup_vertex_array:
+//     location 0 : vec4  (x, y, width, height)
+//     location 1 : vec4  (r, g, b, a)
+//     location 2 : float corner_radius
+//
+struct RectInstance
+{
+    float x{ 0.0f };
+    float y{ 0.0f };
+    float width{ 0.0f };
+    float height{ 0.0f };
+
+    float r{ 0.0f };
+    float g{ 0.0f };
+    float b{ 0.0f };
+    float a{ 1.0f };
+
+    float corner_radius{ 0.0f };
+};
+
+//
+// Rectangles recorded for a frame, grouped into runs of consecutive rectangles using the same material.
+// Only holds CPU memory, so it can be recorded on one thread and drawn by RectBatch on another.
+//
+class RectList
+{
+public:
+    struct Run
+    {
+        std::shared_ptr<Shader> material{ nullptr };
+        unsigned int first{ 0 };
+        unsigned int count{ 0 };
+    };
+
+    void submit(const std::shared_ptr<Shader>& material_, const RectInstance& rect_);
+    void clear();
+
+    bool is_empty() const;
+    const std::vector<RectInstance>& get_instances() const;
+    const std::vector<Run>& get_runs() const;
+
+private:
+    std::vector<RectInstance> m_instances;
+    std::vector<Run> m_runs;
+};
+
+//
+// Collects rectangles for a frame and draws them with one instanced draw call per material.
+// Consecutive submits using the same material are merged into one run, so submission order is kept.
+// Instances are streamed through a persistently mapped StreamBuffer, which is a shared object,
+// while the vertex array must be set up for every OpenGL context.
+//
+class RectBatch
+{
+private:
+    RectBatch();
+    virtual ~RectBatch();
+public:
+    static std::shared_ptr<RectBatch> create();
+
+public:
+    struct Statistics
+    {
+        std::size_t draw_calls{ 0 };
+        std::size_t instances{ 0 };
+        std::size_t uploaded_bytes{ 0 };
+    };
+
+    void setup_vertex_array(VertexArray& va_);
+
+    void begin();
+    void submit(const std::shared_ptr<Shader>& material_, const RectInstance& rect_);
+    void flush(VertexArray& va_, const Size& viewport_, const std::vector<Rect>& clip_rects_ = {});
+    void flush(const RectList& list_, VertexArray& va_, const Size& viewport_,
+               const std::vector<Rect>& clip_rects_ = {});
+
+    const Statistics& get_statistics() const;
+
+private:
+    UniformHandle p_get_viewport_uniform(const std::shared_ptr<Shader>& material_);
+
+    RectList m_list;
+    std::vector<std::pair<std::weak_ptr<Shader>, int>> m_viewport_uniforms;
+
+    std::shared_ptr<StreamBuffer> m_instance_buffer;
+
+    Statistics m_statistics;
+};
+
+
+}
+}
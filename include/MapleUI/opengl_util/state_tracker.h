@@ -0,0 +1,84 @@
+#pragma once
+#include "define.h"
+
+namespace maple
+{
+namespace gl
+{
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+//
+// Shadows the binding state of one OpenGL context, so binds that are already current are skipped.
+// Whoever makes an OpenGL context current must also make its tracker current with make_current,
+// otherwise the wrappers fall back to a per-thread tracker that assumes a single context.
+// Deleted object names are forgotten by every tracker, since names of shared objects may be reused.
+// The bound names are atomic, because an object may be deleted on another thread than the one
+// that owns a tracker, such as the thread running mainloop while a render thread draws.
+//
+class StateTracker
+{
+private:
+    StateTracker();
+    virtual ~StateTracker();
+public:
+    static std::shared_ptr<StateTracker> create();
+
+    static void make_current(StateTracker* tracker_);
+    static StateTracker& get_current();
+
+    static void forget_buffer(unsigned int id_);
+    static void forget_vertex_array(unsigned int id_);
+    static void forget_program(unsigned int id_);
+    static void forget_framebuffer(unsigned int id_);
+
+public:
+    struct Statistics
+    {
+        std::size_t issued{ 0 };
+        std::size_t skipped{ 0 };
+    };
+
+    void bind_buffer(unsigned int target_, unsigned int id_);
+    void bind_vertex_array(unsigned int id_);
+    void use_program(unsigned int id_);
+    void bind_framebuffer(unsigned int target_, unsigned int id_);
+
+    void invalidate();
+
+    const Statistics& get_statistics() const;
+
+private:
+    static constexpr unsigned int unknown = ~0u;
+
+    enum BufferSlot
+    {
+        array_buffer,
+        pixel_pack_buffer,
+        pixel_unpack_buffer,
+        uniform_buffer,
+        copy_read_buffer,
+        copy_write_buffer,
+        draw_indirect_buffer,
+        buffer_slot_count
+    };
+
+    using Binding = std::atomic<unsigned int>;
+
+    static int p_get_buffer_slot(unsigned int target_);
+    static void p_forget(Binding& binding_, unsigned int id_);
+
+    std::array<Binding, buffer_slot_count> m_buffers;
+    Binding m_vertex_array;
+    Binding m_program;
+    Binding m_draw_framebuffer;
+    Binding m_read_framebuffer;
+
+    Statistics m_statistics;
+};
+
+
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "define.h"
+
+namespace maple
+{
+namespace gl
+{
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+//
+// Measures GPU time of passes with GL_TIMESTAMP queries, without ever waiting for the GPU.
+// Every frame takes one slot of queries. Results are collected frames later, once the last query of a slot
+// reports GL_QUERY_RESULT_AVAILABLE, and a frame finding every slot still in flight is not timed at all.
+// Query objects are not shared between OpenGL contexts, so every context needs its own pool.
+//
+class TimerQueryPool
+{
+private:
+    TimerQueryPool(std::size_t frames_in_flight_, std::size_t max_passes_);
+    virtual ~TimerQueryPool();
+public:
+    static std::shared_ptr<TimerQueryPool> create(std::size_t frames_in_flight_ = 4, std::size_t max_passes_ = 8);
+
+public:
+    struct Result
+    {
+        std::uint64_t frame{ 0 };
+        unsigned int pass{ 0 };
+        std::chrono::nanoseconds duration{ 0 };
+    };
+
+    struct Statistics
+    {
+        std::size_t timed_frames{ 0 };
+        std::size_t dropped_frames{ 0 };
+        std::size_t dropped_passes{ 0 };
+    };
+
+    bool begin_frame(std::uint64_t frame_);
+    void begin_pass(unsigned int pass_);
+    void end_pass();
+    void end_frame();
+
+    std::size_t collect(std::vector<Result>& results_);
+
+    const Statistics& get_statistics() const;
+
+private:
+    struct Pass
+    {
+        unsigned int pass{ 0 };
+        unsigned int start{ 0 };
+        unsigned int end{ 0 };
+    };
+
+    struct Slot
+    {
+        std::uint64_t frame{ 0 };
+        bool is_pending{ false };
+        std::vector<unsigned int> queries;
+        std::vector<Pass> passes;
+    };
+
+    std::vector<Slot> m_slots;
+    std::size_t m_next;
+    Slot* m_recording;
+    bool m_is_pass_open;
+
+    Statistics m_statistics;
+};
+
+
+}
+}
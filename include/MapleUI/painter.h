@@ -0,0 +1,50 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+namespace gl
+{
+    class RectList;
+    class Shader;
+}
+
+
+
+// ====================================================================================================================
+//      CLASS: Painter
+// ====================================================================================================================
+
+//
+// Handed to paint callbacks while a Window is drawn.
+// Everything painted is recorded into a list and drawn as a batch at the end of the frame,
+// so painting thousands of rectangles does not cost thousands of draw calls.
+// Coordinates are in framebuffer pixels with the origin at the top left corner.
+// Rectangles outside the damaged region of the frame are dropped before they reach the batch.
+//
+class DamageRegion;
+class Painter
+{
+public:
+    void fill_rect(const Rect& rect_, const Color& color_, float corner_radius_ = 0.0f);
+
+    Size get_size() const;
+
+private:
+    Painter(gl::RectList& list_, const std::shared_ptr<gl::Shader>& material_, const Size& size_,
+            const DamageRegion& damage_);
+
+    gl::RectList& m_list;
+    std::shared_ptr<gl::Shader> m_material;
+    Size m_size;
+    const DamageRegion& m_damage;
+
+    friend class Window;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "define.h"
+#include "instrumentation.h"
+
+#define MAPLE_TRACE_CONCAT_INNER(a_, b_) a_##b_
+#define MAPLE_TRACE_CONCAT(a_, b_) MAPLE_TRACE_CONCAT_INNER(a_, b_)
+
+//
+// MAPLE_TRACE_SCOPE(name, category) records one event from here to the end of the enclosing scope.
+// Only the pointers are stored, so both should be string literals. Compiles to nothing without instrumentation.
+//
+#define MAPLE_TRACE_SCOPE(name_, category_) \
+    MAPLE_INSTRUMENT(::maple::TraceScope MAPLE_TRACE_CONCAT(trace_scope_, __LINE__)(name_, category_);)
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: Tracer
+// ====================================================================================================================
+
+//
+// Writes scoped events of every thread to a Chrome trace-event JSON file, which chrome://tracing
+// and Perfetto open directly. Every thread records into its own buffer without taking a lock,
+// and only allocates when a chunk of the buffer fills up. flush drains every buffer into the file,
+// so a long capture holds no more than the events since the last flush. The file is completed by stop,
+// or at the end of the process if tracing is still active.
+// A capture of a few seconds can be taken by calling start and scheduling stop with FrameScheduler::add_timer.
+//
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Statistics
+    {
+        std::size_t events{ 0 };
+        std::size_t flushes{ 0 };
+    };
+
+    static void start(const std::filesystem::path& path_);
+    static void flush();
+    static void stop();
+    static bool is_active();
+
+    static void set_thread_name(const std::string& name_);
+    static void record(const char* name_, const char* category_, Clock::time_point start_, Clock::time_point end_);
+
+    static Statistics get_statistics();
+};
+
+//
+// Records the time until it goes out of scope, if tracing was active when it was created.
+//
+class TraceScope
+{
+public:
+    TraceScope(const char* name_, const char* category_);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_category;
+    Tracer::Clock::time_point m_start;
+    bool m_is_active;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: TripleBuffer
+// ====================================================================================================================
+
+//
+// Hands values from one writer thread to one reader thread without locks and without either side waiting.
+// This is a double-buffered snapshot with a third slot in the middle: the writer fills its slot and swaps it
+// with the middle one, and the reader swaps its slot with the middle one whenever a newer value is there.
+// Values are reused rather than reallocated, so both sides should clear and refill them.
+//
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer();
+
+    T& get_write_buffer();
+    void publish();
+    bool is_consumed() const;
+
+    bool acquire();
+    T& get_read_buffer();
+
+private:
+    static constexpr std::uint8_t index_mask = 0x3;
+    static constexpr std::uint8_t fresh_bit = 0x4;
+
+    std::array<T, 3> m_buffers;
+    std::atomic<std::uint8_t> m_middle;
+    std::uint8_t m_write;
+    std::uint8_t m_read;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer()
+    : m_middle{ 1 },
+      m_write{ 0 },
+      m_read{ 2 }
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Writer side.
+//
+template <typename T>
+T& TripleBuffer<T>::get_write_buffer()
+{
+    return m_buffers[m_write];
+}
+
+//
+// Makes the write buffer visible to the reader. A published value that was never acquired is replaced,
+// so a writer that must not drop values checks is_consumed first.
+//
+template <typename T>
+void TripleBuffer<T>::publish()
+{
+    m_write = m_middle.exchange(m_write | fresh_bit, std::memory_order_acq_rel) & index_mask;
+}
+
+template <typename T>
+bool TripleBuffer<T>::is_consumed() const
+{
+    return !(m_middle.load(std::memory_order_acquire) & fresh_bit);
+}
+
+//
+// Reader side. Returns false and keeps the current read buffer when nothing new was published.
+//
+template <typename T>
+bool TripleBuffer<T>::acquire()
+{
+    if (!(m_middle.load(std::memory_order_acquire) & fresh_bit))
+        return false;
+
+    m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & index_mask;
+    return true;
+}
+
+template <typename T>
+T& TripleBuffer<T>::get_read_buffer()
+{
+    return m_buffers[m_read];
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "../define.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//      CLASS: LayoutStyle
+// ====================================================================================================================
+
+//
+// none leaves the children where their rects put them, the others lay them out in a row or a column.
+//
+enum class FlexDirection : std::uint8_t
+{
+    none,
+    row,
+    column
+};
+
+//
+// Where the children go along the main axis when they do not grow to fill it.
+//
+enum class FlexJustify : std::uint8_t
+{
+    start,
+    center,
+    end,
+    space_between
+};
+
+//
+// Where the children go across the main axis. stretch fills it with every child without a fixed size.
+//
+enum class FlexAlign : std::uint8_t
+{
+    start,
+    center,
+    end,
+    stretch
+};
+
+//
+// How a widget lays out its children, and how it is laid out by a parent whose direction is not none.
+// width and height fix the size of the widget, auto_size takes the size of its content.
+// Along the main axis of the parent, free space is handed out in proportion to grow,
+// and missing space is taken back in proportion to shrink times the size of the content.
+// padding is kept free on every side of the children, and gap between every two of them.
+//
+struct LayoutStyle
+{
+    static constexpr int auto_size = -1;
+
+    FlexDirection direction{ FlexDirection::none };
+    FlexJustify justify{ FlexJustify::start };
+    FlexAlign align{ FlexAlign::stretch };
+    int padding{ 0 };
+    int gap{ 0 };
+
+    int width{ auto_size };
+    int height{ auto_size };
+    float grow{ 0.0f };
+    float shrink{ 1.0f };
+};
+
+//
+// The space a widget may take when it is measured. unbounded along the main axis of its parent.
+//
+struct LayoutConstraints
+{
+    static constexpr int unbounded = std::numeric_limits<int>::max();
+
+    int max_width{ unbounded };
+    int max_height{ unbounded };
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
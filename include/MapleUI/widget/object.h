@@ -1,33 +1,113 @@
 #pragma once
-#include "define.h"
+#include "../define.h"
+#include "widget_storage.h"
+
+
 
 namespace maple
 {
 
-    class Object
-    {
-    protected:
-        Object(std::shared_ptr<Object> parent_);
-        virtual ~Object();
-    protected:
-        consteval virtual bool parentable() = 0;
-
-    public:
-        virtual void render() = 0;
-
-        
-    };
-
-    class Frame : public Object
-    {
-    protected:
-        Frame(std::shared_ptr<Object> parent_);
-        virtual ~Frame() override;
-    protected:
-        consteval virtual bool parentable() { return true; };
-
-    public:
-        virtual void render() override;
-    };
-
-}
\ No newline at end of file
+class DamageRegion;
+
+
+
+// ====================================================================================================================
+//      CLASS: Object
+// ====================================================================================================================
+
+//
+// A node of the retained widget tree of a Window. Its rect is relative to its parent, and the rect
+// in window coordinates is cached and only recomputed when the node or one of its ancestors moved.
+// Every change marks the node, and every ancestor as leading to a changed node, so updating a frame
+// only walks the paths down to what changed, and damages the window where it changed.
+// Drawing walks every node that intersects the damage, parents before children, and skips whole subtrees
+// outside of it, so children are expected to lie within their parent.
+// An Object is only a handle to its row in the WidgetStorage of its tree, which holds everything touched
+// while walking the tree. Widgets that draw more than their draw data enable a custom render.
+// A widget whose layout style has a direction lays out its children as a flex container, see LayoutStyle.
+// Widgets with content of their own, such as text, enable a custom measure and invalidate their layout
+// when the size of that content changes; only the containers whose size depends on it are laid out again.
+// Layout may run on the workers of a JobSystem, so measure may be called for several widgets at once.
+// Nodes are owned by their parent. Widgets are created with the parent they are added to,
+// and a node that is not attached to the root of a Window is neither updated nor drawn.
+// Only the thread running the event loop may touch the tree.
+//
+class Object : public std::enable_shared_from_this<Object>
+{
+protected:
+    Object(std::shared_ptr<Object> parent_);
+    virtual ~Object();
+protected:
+    virtual bool parentable() const = 0;
+
+    void set_custom_render(bool is_custom_);
+    void set_custom_measure(bool is_custom_);
+    WidgetStorage& get_storage() const;
+    const WidgetHandle& get_handle() const;
+
+public:
+    virtual void render(Painter& painter_) = 0;
+    virtual Size measure(const LayoutConstraints& constraints_);
+
+    void set_rect(const Rect& rect_);
+    const Rect& get_rect() const;
+    const Rect& get_world_rect() const;
+
+    void set_layout_style(const LayoutStyle& style_);
+    const LayoutStyle& get_layout_style() const;
+
+    void invalidate();
+    void invalidate_layout();
+    void add_child(std::shared_ptr<Object> child_);
+    void remove();
+
+    Object* get_parent() const;
+    const std::vector<std::shared_ptr<Object>>& get_children() const;
+    bool has_changes() const;
+    std::uint64_t get_change_count() const;
+
+    void layout(JobSystem* job_system_ = nullptr);
+    void update(DamageRegion& damage_);
+    void draw(Painter& painter_, const DamageRegion& damage_);
+
+private:
+    void p_move_to(const std::shared_ptr<WidgetStorage>& storage_);
+
+    std::shared_ptr<WidgetStorage> m_storage;
+    WidgetHandle m_handle;
+    Object* m_parent;
+    std::vector<std::shared_ptr<Object>> m_children;
+};
+
+
+
+// ====================================================================================================================
+//      CLASS: Frame
+// ====================================================================================================================
+
+//
+// A rectangle filled with one color that holds other widgets. Transparent by default.
+//
+class Frame : public Object
+{
+public:
+    static std::shared_ptr<Frame> create(std::shared_ptr<Object> parent_);
+    static std::shared_ptr<Frame> create(std::shared_ptr<Object> parent_, const Rect& rect_, const Color& color_);
+
+protected:
+    Frame(std::shared_ptr<Object> parent_);
+    virtual ~Frame() override;
+protected:
+    virtual bool parentable() const override { return true; };
+
+public:
+    virtual void render(Painter& painter_) override;
+
+    void set_color(const Color& color_);
+    const Color& get_color() const;
+    void set_corner_radius(float corner_radius_);
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include "../define.h"
+#include "layout.h"
+
+
+
+namespace maple
+{
+
+class Object;
+class DamageRegion;
+class FlexLayout;
+class JobSystem;
+
+
+
+// ====================================================================================================================
+//      CLASS: WidgetStorage
+// ====================================================================================================================
+
+//
+// Names one widget in a WidgetStorage. Stays valid while the widget moves around in the tables,
+// and stops matching once the widget is released, even if its slot is reused.
+//
+struct WidgetHandle
+{
+    static constexpr std::uint32_t invalid_index = std::numeric_limits<std::uint32_t>::max();
+
+    std::uint32_t index{ invalid_index };
+    std::uint32_t generation{ 0 };
+};
+
+//
+// The data of every widget of a tree that is touched each frame, kept in one table per field.
+// Rows are kept in depth-first order, so the subtree of a row is the subtree_size rows starting at it,
+// walking a tree is a linear scan, and skipping a subtree is an addition.
+// Adding a widget to the end of the tree, which is what building a tree top-down does, keeps the order.
+// Any other change of the structure appends or leaves holes, and the tables are sorted again before the next walk.
+// Widgets without a parent are roots; a Window draws one of them, the others are removed subtrees.
+// Layout flags track which rows have to be laid out again, see p_invalidate_layout.
+//
+class WidgetStorage
+{
+    friend class FlexLayout;
+
+private:
+    WidgetStorage();
+    virtual ~WidgetStorage();
+public:
+    static std::shared_ptr<WidgetStorage> create();
+
+public:
+    static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    enum Flag : std::uint8_t
+    {
+        flag_moved                  = 1 << 0,
+        flag_changed                = 1 << 1,
+        flag_descendant_changed     = 1 << 2,
+        flag_custom_render          = 1 << 3,
+        flag_alive                  = 1 << 4,
+
+        // set while updating, read by the children of the row
+        flag_moved_in_update        = 1 << 5,
+        flag_damaged_in_update      = 1 << 6
+    };
+
+    enum LayoutFlag : std::uint8_t
+    {
+        layout_dirty                = 1 << 0,
+        layout_descendant_dirty     = 1 << 1,
+        layout_custom_measure       = 1 << 2
+    };
+
+    //
+    // What a widget draws without a render override: a filled, possibly rounded, rectangle.
+    //
+    struct DrawData
+    {
+        Color color{ .r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 0.0f };
+        float corner_radius{ 0.0f };
+    };
+
+    //
+    // The last sizes a widget measured, keyed by the constraints they were measured under.
+    // A parent measures its children under the same constraints until its own size changes,
+    // so two entries cover measuring for the parent and arranging with its final size.
+    //
+    struct MeasureCache
+    {
+        static constexpr std::size_t capacity = 2;
+
+        struct Entry
+        {
+            LayoutConstraints constraints{};
+            Size size{};
+        };
+
+        std::array<Entry, capacity> entries{};
+        std::uint8_t count{ 0 };
+        std::uint8_t next{ 0 };
+
+        const Size* find(const LayoutConstraints& constraints_) const;
+        void add(const LayoutConstraints& constraints_, const Size& size_);
+        void clear();
+    };
+
+    struct Statistics
+    {
+        std::size_t sorts{ 0 };
+        std::size_t updated_rows{ 0 };
+        std::size_t drawn_rows{ 0 };
+        std::size_t arranged_rows{ 0 };
+        std::size_t measured_rows{ 0 };
+    };
+
+    WidgetHandle allocate(Object* object_);
+    void release(const WidgetHandle& handle_);
+    bool contains(const WidgetHandle& handle_) const;
+
+    void attach(const WidgetHandle& parent_, const WidgetHandle& child_);
+    void detach(const WidgetHandle& handle_);
+
+    void set_rect(const WidgetHandle& handle_, const Rect& rect_);
+    const Rect& get_rect(const WidgetHandle& handle_) const;
+    const Rect& get_world_rect(const WidgetHandle& handle_) const;
+    void set_draw_data(const WidgetHandle& handle_, const DrawData& draw_data_);
+    const DrawData& get_draw_data(const WidgetHandle& handle_) const;
+    void set_custom_render(const WidgetHandle& handle_, bool is_custom_);
+    bool get_custom_render(const WidgetHandle& handle_) const;
+    void set_layout_style(const WidgetHandle& handle_, const LayoutStyle& style_);
+    const LayoutStyle& get_layout_style(const WidgetHandle& handle_) const;
+    void set_custom_measure(const WidgetHandle& handle_, bool is_custom_);
+    bool get_custom_measure(const WidgetHandle& handle_) const;
+    void invalidate_layout(const WidgetHandle& handle_);
+
+    void mark(const WidgetHandle& handle_, std::uint8_t flags_);
+    bool has_changes(const WidgetHandle& handle_) const;
+
+    void sort();
+    void layout(const WidgetHandle& root_, JobSystem* job_system_ = nullptr);
+    void update(const WidgetHandle& root_, DamageRegion& damage_);
+    void draw(const WidgetHandle& root_, Painter& painter_, const DamageRegion& damage_);
+
+    std::size_t get_size() const;
+    std::uint64_t get_change_count() const;
+    const Statistics& get_statistics() const;
+
+private:
+    std::uint32_t p_get_row(const WidgetHandle& handle_) const;
+    void p_append_row();
+    void p_mark(std::uint32_t row_, std::uint8_t flags_, std::uint32_t boundary_ = none);
+    void p_unlink(std::uint32_t row_);
+    void p_invalidate_layout(std::uint32_t row_);
+    void p_mark_layout(std::uint32_t row_);
+    bool p_is_flex_container(std::uint32_t row_) const;
+    bool p_set_layout_rect(std::uint32_t row_, const Rect& rect_, std::uint32_t boundary_);
+
+    // one entry per row
+
+    std::vector<Rect> m_rects;
+    std::vector<Rect> m_world_rects;
+    std::vector<std::uint8_t> m_flags;
+    std::vector<std::uint32_t> m_parents;
+    std::vector<std::uint32_t> m_first_children;
+    std::vector<std::uint32_t> m_last_children;
+    std::vector<std::uint32_t> m_next_siblings;
+    std::vector<std::uint32_t> m_subtree_sizes;
+    std::vector<DrawData> m_draw_data;
+    std::vector<LayoutStyle> m_layout_styles;
+    std::vector<std::uint8_t> m_layout_flags;
+    std::vector<MeasureCache> m_measure_caches;
+    std::vector<Object*> m_objects;
+    std::vector<std::uint32_t> m_slots;
+
+    // one entry per handle index
+
+    std::vector<std::uint32_t> m_rows;
+    std::vector<std::uint32_t> m_generations;
+    std::vector<std::uint32_t> m_free_slots;
+
+    std::size_t m_dead_rows;
+    std::uint64_t m_change_count;
+    bool m_is_sorted;
+    Statistics m_statistics;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -1,6 +1,16 @@
 #include "context.h"
 
+#include "painter.h"
+#include "damage_region.h"
+#include "tracing.h"
 #include "opengl_util/general.h"
+#include "opengl_util/rect_batch.h"
+#include "opengl_util/state_tracker.h"
+#include "opengl_util/program_cache.h"
+#include "opengl_util/timer_query.h"
+#include "opengl_util/pixel_reader.h"
+#include "opengl_util/fence_tracker.h"
+#include "platform/surface.h"
 
 #include <glad/gl.h>
 #define GLFW_INCLUDE_NONE
@@ -13,99 +23,6 @@ namespace
 
 
 
-// ====================================================================================================================
-//      INTERNAL CLASS: LibGLFWInitializer
-// ====================================================================================================================
-
-//
-// Initialize the GLFW library and load OpenGL functions using Glad.
-// Once initialized, it will be valid until the end of program.
-//
-class LibGLFWInitializer
-{
-public:
-    LibGLFWInitializer();
-    ~LibGLFWInitializer();
-
-    void initialize();
-
-    bool is_initialized() const;
-
-private:
-    static void error_callback(int error_code_, const char* description_);
-
-    bool m_is_initialized;
-};
-
-// --------------------------------------------------------------------------------------------------------------------
-
-LibGLFWInitializer lib_glfw_initializer;
-
-// --------------------------------------------------------------------------------------------------------------------
-
-LibGLFWInitializer::LibGLFWInitializer()
-    : m_is_initialized{ false }
-{
-}
-
-LibGLFWInitializer::~LibGLFWInitializer()
-{
-    if (!is_initialized())
-        return;
-
-    glfwTerminate();
-    m_is_initialized = false;
-}
-
-// --------------------------------------------------------------------------------------------------------------------
-
-void LibGLFWInitializer::initialize()
-{
-    if (is_initialized())
-        return;
-
-    if (!glfwInit())
-    throw std::runtime_error("void LibGLFWInitializer::initialize(): "
-                             "Failed to initialize GLFW. glfwInit()");
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
-                   maple::configuration::opengl_version_major);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
-                   maple::configuration::opengl_version_major);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-
-    GLFWwindow* dummy = glfwCreateWindow(100, 100,
-                                         "", nullptr, nullptr);
-    if (!dummy)
-        throw std::runtime_error("void LibGLFWInitializer::initialize(): "
-                                 "Failed to create window. glfwCreateWindow()");
-    glfwMakeContextCurrent(dummy);
-    if (!gladLoadGL(glfwGetProcAddress))
-        throw std::runtime_error("void LibGLFWInitializer::initialize(): "
-                                 "Failed to create opengl context. gladLoadGL()");
-    glfwDestroyWindow(dummy);
-
-    m_is_initialized = true;
-}
-
-bool LibGLFWInitializer::is_initialized() const
-{
-    return m_is_initialized;
-}
-
-// --------------------------------------------------------------------------------------------------------------------
-
-void LibGLFWInitializer::error_callback(int error_code_, const char* description_)
-{
-    std::cerr << "GLFW error callback: [ " << error_code_ << " ] "
-              << description_ << "\n";
-}
-
-// --------------------------------------------------------------------------------------------------------------------
-
-
-
 // ====================================================================================================================
 //      shader source code used by InternalRenderer
 // ====================================================================================================================
@@ -113,25 +30,49 @@ void LibGLFWInitializer::error_callback(int error_code_, const char* description
 namespace shader
 {
 
-std::string quad_vertex = R"(
+std::string rect_vertex = R"(
     #version 330 core
-    layout (location = 0) in vec3 position;
+    layout (location = 0) in vec4 i_rect;
+    layout (location = 1) in vec4 i_color;
+    layout (location = 2) in float i_corner_radius;
+
+    uniform vec2 u_viewport;
+
+    out vec2 v_local;
+    out vec4 v_color;
+    flat out vec2 v_half_size;
+    flat out float v_corner_radius;
 
     void main()
     {
-        gl_Position = vec4(position.x/2, position.y/2, position.z/2, 1.0);
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 pixel = i_rect.xy + corner * i_rect.zw;
+
+        v_local = (corner - 0.5) * i_rect.zw;
+        v_color = i_color;
+        v_half_size = i_rect.zw * 0.5;
+        v_corner_radius = min(i_corner_radius, min(v_half_size.x, v_half_size.y));
+
+        gl_Position = vec4(pixel / u_viewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
     }
 )";
 
-std::string quad_fragment = R"(
+std::string rect_fragment = R"(
     #version 330 core
     layout (location = 0) out vec4 frag_color;
 
-    uniform vec4 u_color;
+    in vec2 v_local;
+    in vec4 v_color;
+    flat in vec2 v_half_size;
+    flat in float v_corner_radius;
 
     void main()
     {
-        frag_color = u_color;
+        vec2 q = abs(v_local) - v_half_size + v_corner_radius;
+        float distance = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - v_corner_radius;
+        float coverage = v_corner_radius > 0.0 ? clamp(0.5 - distance, 0.0, 1.0) : 1.0;
+
+        frag_color = vec4(v_color.rgb, v_color.a * coverage);
     }
 )";
 
@@ -147,7 +88,7 @@ std::string quad_fragment = R"(
 // Only handles rendering.
 // Will generate objects and set states for OpenGL context,
 // but the context sharing part should be managed by Context and Window class
-// by passing in the correct GLFWwindow* during generate_shared_objects
+// by passing in the correct platform::Surface during generate_shared_objects
 // and generate_window_states.
 //
 class InternalRenderer
@@ -159,10 +100,16 @@ public:
     InternalRenderer();
     ~InternalRenderer();
 
-    SharedObjects generate_shared_objects(GLFWwindow* shared_gl_context_);
-    WindowStates generate_window_states(const SharedObjects& objs_, GLFWwindow* window_);
+    SharedObjects generate_shared_objects(maple::platform::Surface& shared_surface_,
+                                          const std::shared_ptr<maple::gl::ProgramBinaryCache>& program_cache_);
+    WindowStates generate_window_states(const SharedObjects& objs_, maple::platform::Surface& surface_);
 
-    void draw_quad(const SharedObjects& objs_, const WindowStates& states_);
+    unsigned int prepare_render_target(WindowStates& states_, maple::platform::Surface& surface_,
+                                       const maple::Size& viewport_);
+    void clear_damage(const maple::DamageRegion& damage_, const maple::Size& viewport_);
+    void draw_rects(const SharedObjects& objs_, const WindowStates& states_, const maple::Size& viewport_,
+                    const maple::gl::RectList& rects_, const maple::DamageRegion& damage_);
+    void blit_to_surface(const WindowStates& states_, maple::platform::Surface& surface_);
 };
 
 //
@@ -172,8 +119,8 @@ public:
 //
 struct InternalRenderer::SharedObjects
 {
-    std::shared_ptr<maple::gl::VertexBuffer> quad_vb{ nullptr };
-    std::shared_ptr<maple::gl::Shader> quad_shader{ nullptr };
+    std::shared_ptr<maple::gl::RectBatch> rect_batch{ nullptr };
+    std::shared_ptr<maple::gl::Shader> rect_shader{ nullptr };
 };
 
 //
@@ -182,7 +129,11 @@ struct InternalRenderer::SharedObjects
 //
 struct InternalRenderer::WindowStates
 {
-    std::shared_ptr<maple::gl::VertexArray> quad_va{ nullptr };
+    std::shared_ptr<maple::gl::VertexArray> rect_va{ nullptr };
+    std::shared_ptr<maple::gl::Framebuffer> back_framebuffer{ nullptr };
+    std::shared_ptr<maple::gl::TimerQueryPool> gpu_timer{ nullptr };
+    std::shared_ptr<maple::gl::PixelReader> pixel_reader{ nullptr };
+    std::shared_ptr<maple::gl::FenceTracker> fence_tracker{ nullptr };
 };
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -206,24 +157,19 @@ InternalRenderer::~InternalRenderer()
 //
 // Used by Context class to created shared OpenGL objects.
 //
-InternalRenderer::SharedObjects InternalRenderer::generate_shared_objects(GLFWwindow* shared_gl_context_)
+InternalRenderer::SharedObjects InternalRenderer::generate_shared_objects(maple::platform::Surface& shared_surface_,
+                                                                         const std::shared_ptr<maple::gl::ProgramBinaryCache>& program_cache_)
 {
-    glfwMakeContextCurrent(shared_gl_context_);
+    shared_surface_.make_current();
 
     using namespace maple::gl;
 
+    // the driver may compile the program while the buffers of the batch are created
+    auto rect_shader = ShaderFuture::create(shader::rect_vertex, shader::rect_fragment, program_cache_);
+
     SharedObjects objs;
-    objs.quad_vb = VertexBuffer::create();
-    float vertices[] = {
-            -1.0f,  1.0f,  0.0f,
-             1.0f,  1.0f,  0.0f,
-             1.0f, -1.0f,  0.0f,
-             1.0f, -1.0f,  0.0f,
-            -1.0f, -1.0f,  0.0f,
-            -1.0f,  1.0f,  0.0f
-    };
-    glBufferData(GL_ARRAY_BUFFER, sizeof vertices, vertices, GL_STATIC_DRAW);
-    objs.quad_shader = Shader::create(shader::quad_vertex, shader::quad_fragment);
+    objs.rect_batch = RectBatch::create();
+    objs.rect_shader = rect_shader->get();
 
     return objs;
 }
@@ -231,31 +177,87 @@ InternalRenderer::SharedObjects InternalRenderer::generate_shared_objects(GLFWwi
 //
 // Used by individual Window class to set OpenGL context state.
 //
-InternalRenderer::WindowStates InternalRenderer::generate_window_states(const SharedObjects& objs_, GLFWwindow* window_)
+InternalRenderer::WindowStates InternalRenderer::generate_window_states(const SharedObjects& objs_,
+                                                                       maple::platform::Surface& surface_)
 {
-    glfwMakeContextCurrent(window_);
+    surface_.make_current();
 
     using namespace maple::gl;
 
     WindowStates states;
-    states.quad_va = VertexArray::create();
-    objs_.quad_vb->bind();
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void*>(0));
-    glEnableVertexAttribArray(0);
+    states.rect_va = VertexArray::create();
+    objs_.rect_batch->setup_vertex_array(*states.rect_va);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    MAPLE_INSTRUMENT(
+        states.gpu_timer = TimerQueryPool::create();
+        states.fence_tracker = FenceTracker::create();
+    )
 
     return states;
 }
 
+//
+// Returns the framebuffer a window renders into.
+// The back buffer of a window is undefined after every swap, so windows render into a framebuffer object
+// that keeps the previous frame, and only the damaged parts of it are redrawn. Headless surfaces already
+// render into one. Whoever records the frame damages the whole window when its size changes.
+//
+unsigned int InternalRenderer::prepare_render_target(WindowStates& states_, maple::platform::Surface& surface_,
+                                                     const maple::Size& viewport_)
+{
+    if (surface_.get_framebuffer_id() == 0)
+    {
+        if (!states_.back_framebuffer)
+            states_.back_framebuffer = maple::gl::Framebuffer::create(viewport_);
+        else if (maple::Size current = states_.back_framebuffer->get_size();
+                 current.width != viewport_.width || current.height != viewport_.height)
+            states_.back_framebuffer->resize(viewport_);
+    }
+
+    return states_.back_framebuffer ? states_.back_framebuffer->get_id() : surface_.get_framebuffer_id();
+}
+
+void InternalRenderer::clear_damage(const maple::DamageRegion& damage_, const maple::Size& viewport_)
+{
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glEnable(GL_SCISSOR_TEST);
+    for (auto& rect : damage_.get_rects())
+    {
+        glScissor(rect.x, viewport_.height - rect.y - rect.height, rect.width, rect.height);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
 //
 // Uses the SharedObjects from parent Context class and WindowStates from individual Window class.
+// Draws every painted rectangle with one instanced draw call per material and damaged rectangle.
 //
-void InternalRenderer::draw_quad(const SharedObjects& objs_, const WindowStates& states_)
+void InternalRenderer::draw_rects(const SharedObjects& objs_, const WindowStates& states_, const maple::Size& viewport_,
+                                  const maple::gl::RectList& rects_, const maple::DamageRegion& damage_)
 {
-    objs_.quad_shader->bind();
-    states_.quad_va->bind();
-    objs_.quad_shader->set_uniform_vec4("u_color", 0.3f, 0.4f, 0.5f, 1.0f);
+    objs_.rect_batch->begin();
+    objs_.rect_batch->flush(rects_, *states_.rect_va, viewport_, damage_.get_rects());
+}
 
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+//
+// Copies the whole framebuffer object to the window, before swapping.
+// A blit is a plain copy, so it stays far cheaper than redrawing the window even though it is not clipped.
+//
+void InternalRenderer::blit_to_surface(const WindowStates& states_, maple::platform::Surface& surface_)
+{
+    if (states_.back_framebuffer)
+    {
+        maple::Size size = states_.back_framebuffer->get_size();
+        glBlitNamedFramebuffer(states_.back_framebuffer->get_id(), surface_.get_framebuffer_id(),
+                               0, 0, size.width, size.height,
+                               0, 0, size.width, size.height,
+                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -273,23 +275,84 @@ namespace maple
 //     CLASS: Context
 // ====================================================================================================================
 
+//
+// Everything recorded for one window on the thread running mainloop, and drawn by whichever thread owns
+// the OpenGL contexts.
+//
+struct Window::Frame
+{
+    Size viewport{};
+    DamageRegion damage{};
+    gl::RectList commands{};
+    int swap_interval{ 0 };
+    bool is_swap_managed{ false };
+    bool is_captured{ false };
+
+    // false when the frame only collects results of earlier frames, and draws and swaps nothing
+    bool is_drawn{ false };
+
+    // when the input events this frame is the first to show arrived
+    std::vector<InputEvent::Clock::time_point> input_times{};
+
+    FrameRecord timing{};
+};
+
+//
+// One pass over the windows, handed from mainloop to the render thread.
+//
+struct Context::RenderSnapshot
+{
+    std::uint64_t generation{ 0 };
+    std::vector<std::shared_ptr<Window>> windows;
+    std::vector<Window::Frame> frames;
+
+    FrameRecord timing{};
+};
+
 struct Context::InternalData
 {
-    GLFWwindow* shared_gl_context{ nullptr };
+    std::unique_ptr<platform::Surface> shared_surface{ nullptr };
+    std::shared_ptr<gl::ProgramBinaryCache> program_cache{ nullptr };
     InternalRenderer::SharedObjects renderer_shared_objects;
 
+    std::shared_ptr<FrameScheduler> scheduler{ FrameScheduler::create() };
+    std::shared_ptr<FrameTimeline> timeline{ FrameTimeline::create() };
+    std::shared_ptr<JobSystem> job_system{ nullptr };
+    FrameRecord pending_timing{};
+    std::uint64_t frame_counter{ 0 };
+
     bool is_mainloop_running{ false };
     std::vector<std::shared_ptr<Window>> windows;
+    std::vector<std::pair<std::shared_ptr<Window>, std::uint64_t>> closing_windows;
+
+    std::thread render_thread;
+    std::atomic<bool> is_render_thread_stopping{ false };
+    TripleBuffer<RenderSnapshot> snapshots;
+    std::atomic<std::uint64_t> published_generation{ 0 };
+    std::atomic<std::uint64_t> rendered_generation{ 0 };
 };
 
 // --------------------------------------------------------------------------------------------------------------------
 
+std::shared_ptr<Context> Context::create(const ContextProperties& props_)
+{
+    struct MakeSharedEnabler : public Context
+    {
+        MakeSharedEnabler(const ContextProperties& props_)
+            : Context(props_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(props_);
+}
+
 std::shared_ptr<Context> Context::create()
 {
-    struct MakeSharedEnabler : public Context {};
-    return std::make_shared<MakeSharedEnabler>();
+    return create(ContextProperties{});
 }
 
+//
+// Runs until every window is closed. A headless Context has no events to wait for,
+// so its mainloop also returns once no window is invalidated and no timer is pending.
+//
 bool Context::mainloop()
 {
     m_internal->is_mainloop_running = true;
@@ -297,63 +360,390 @@ bool Context::mainloop()
     for (auto& window : m_internal->windows)
         window->p_show();
 
-    while (m_internal->windows.size() > 0)
+    if (m_prop.is_render_thread_enabled)
+        p_start_render_thread();
+
+    MAPLE_INSTRUMENT(Tracer::set_thread_name("mainloop");)
+
+    auto& scheduler = *m_internal->scheduler;
+    while (m_internal->windows.size() > 0 || m_internal->closing_windows.size() > 0)
     {
-        int index_of_window_just_closed = -1;
-        for (int i = 0; auto& window : m_internal->windows)
         {
-            if (window->p_is_close_approved())
-            {
-                window->p_close();
-                index_of_window_just_closed = i;
+            MAPLE_TRACE_SCOPE("FrameScheduler::run_due", "mainloop");
+            scheduler.run_due(FrameScheduler::Clock::now());
+        }
+        if (m_internal->render_thread.joinable())
+        {
+            p_close_windows();
+            p_dispatch_input();
+            p_publish_frame();
+        }
+        else
+            draw();
+
+        MAPLE_INSTRUMENT(PhaseTimer wait_timer(m_internal->pending_timing, FramePhase::event_wait);)
+        MAPLE_TRACE_SCOPE("Context::mainloop wait", "mainloop");
+
+        auto deadline = scheduler.get_next_deadline();
+        if (std::ranges::any_of(m_internal->windows, [](auto& window_) { return window_->p_is_polling(); }))
+        {
+            auto poll = FrameScheduler::Clock::now() + configuration::poll_interval;
+            deadline = deadline ? std::min(*deadline, poll) : poll;
+        }
+
+        if (m_prop.is_headless)
+        {
+            bool is_invalidated = std::ranges::any_of(m_internal->windows,
+                                                      [](auto& window_) { return window_->p_is_invalidated(); });
+            std::uint64_t rendered = m_internal->rendered_generation.load();
+            if (rendered != m_internal->published_generation.load())
+                m_internal->rendered_generation.wait(rendered);
+            else if (!deadline && !is_invalidated && m_internal->closing_windows.empty())
                 break;
-            }
+            else if (deadline && !is_invalidated)
+                std::this_thread::sleep_until(*deadline);
+        }
+        else if (deadline)
+        {
+            auto timeout = std::chrono::duration<double>(*deadline - FrameScheduler::Clock::now());
+            glfwWaitEventsTimeout(std::max(timeout.count(), 0.0));
+        }
+        else
+            glfwWaitEvents();
+    }
+
+    p_stop_render_thread();
+    m_internal->is_mainloop_running = false;
+
+    return true;
+}
+
+//
+// Closes the windows that were asked to close and draws every other window that was invalidated.
+// mainloop calls this after every batch of events. In headless mode, where there are no events,
+// it can also be called directly to produce frames one at a time.
+//
+void Context::draw()
+{
+    if (m_internal->render_thread.joinable())
+        throw std::runtime_error("void Context::draw(): "
+                                 "Windows are drawn by the render thread while mainloop is running.");
+
+    MAPLE_TRACE_SCOPE("Context::draw", "mainloop");
+
+    p_close_windows();
+    p_dispatch_input();
+    MAPLE_INSTRUMENT(m_internal->pending_timing.frame = m_internal->frame_counter;)
 
-            window->p_draw();
+    // every window is recorded before any is drawn, so the window waiting for vertical blank
+    // is picked among the windows that actually draw in this pass: the last one without an explicit
+    // swap interval, which is drawn last so no other window waits behind it
 
-            i++;
+    std::vector<Window*> recorded;
+    std::optional<std::size_t> vsync;
+    for (auto& window : m_internal->windows)
+    {
+        // a window that is only polling collects its readbacks and fences without counting as a frame
+        bool is_invalidated = window->p_is_invalidated();
+        if (!is_invalidated && !window->p_is_polling())
+        {
+            m_statistics.skipped_frames++;
+            continue;
         }
 
-        if (index_of_window_just_closed != -1)
-            m_internal->windows.erase(m_internal->windows.begin() + index_of_window_just_closed);
+        auto& frame = window->p_get_frame();
+        if (!window->p_record(frame))
+        {
+            if (is_invalidated)
+                m_statistics.skipped_frames++;
+            continue;
+        }
+
+        if (!frame.is_drawn)
+        {
+            if (is_invalidated)
+                m_statistics.skipped_frames++;
+        }
+        else
+        {
+            if (frame.is_swap_managed)
+                vsync = recorded.size();
+            m_statistics.drawn_frames++;
+        }
+        recorded.push_back(window.get());
+    }
 
-        glfwWaitEvents();
+    if (vsync)
+    {
+        recorded[*vsync]->p_get_frame().swap_interval = 1;
+        std::rotate(recorded.begin() + *vsync, recorded.begin() + *vsync + 1, recorded.end());
     }
 
-    return true;
+    for (Window* window : recorded)
+        window->p_draw(m_internal->pending_timing);
+
+    MAPLE_INSTRUMENT(
+        if (m_internal->pending_timing.window_count > 0)
+        {
+            m_internal->timeline->push(m_internal->pending_timing);
+            m_internal->pending_timing = FrameRecord{};
+            m_internal->frame_counter++;
+        }
+    )
+}
+
+FrameScheduler& Context::get_scheduler()
+{
+    return *m_internal->scheduler;
+}
+
+FrameTimeline& Context::get_frame_timeline()
+{
+    return *m_internal->timeline;
+}
+
+//
+// Lays out the widgets of every window, and runs jobs of the application, such as decoding images,
+// which the thread running mainloop can wait for from a callback without blocking the workers.
+//
+JobSystem& Context::get_job_system()
+{
+    return *m_internal->job_system;
+}
+
+const Context::Statistics& Context::get_statistics() const
+{
+    return m_statistics;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
 
-Context::Context()
-    : m_internal{ std::make_shared<InternalData>() }
+//
+// A window asked to close stops being drawn at once, but its surface is only destroyed
+// after the render thread has finished the last snapshot that still contained it.
+//
+void Context::p_close_windows()
 {
-    if (!lib_glfw_initializer.is_initialized())
-        lib_glfw_initializer.initialize();
+    std::erase_if(m_internal->windows, [this](auto& window_)
+        {
+            if (!window_->p_is_close_approved())
+                return false;
 
-    // setup up shared opengl context
+            m_internal->closing_windows.emplace_back(window_, window_->p_get_generation());
+            return true;
+        });
+
+    std::uint64_t rendered = m_internal->rendered_generation.load(std::memory_order_acquire);
+    std::erase_if(m_internal->closing_windows, [rendered](auto& closing_)
+        {
+            if (closing_.second > rendered)
+                return false;
+
+            closing_.first->p_close();
+            return true;
+        });
+}
+
+//
+// Input is dispatched before anything is drawn, so callbacks that invalidate a window are drawn in the same frame.
+// The list is copied since a callback may create or close windows.
+//
+void Context::p_dispatch_input()
+{
+    MAPLE_TRACE_SCOPE("Context::p_dispatch_input", "mainloop");
+
+    auto windows = m_internal->windows;
+    for (auto& window : windows)
+        window->p_dispatch_input();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Every context, including the shared one, is released by this thread before the render thread takes them over.
+//
+void Context::p_start_render_thread()
+{
+    m_internal->shared_surface->release_current();
+    m_internal->is_render_thread_stopping = false;
+    m_internal->render_thread = std::thread(&Context::p_render_thread_main, this);
+}
+
+void Context::p_stop_render_thread()
+{
+    if (!m_internal->render_thread.joinable())
+        return;
+
+    m_internal->is_render_thread_stopping = true;
+    m_internal->published_generation++;
+    m_internal->published_generation.notify_one();
+    m_internal->render_thread.join();
+
+    m_internal->rendered_generation = m_internal->published_generation.load();
+    p_close_windows();
+}
+
+//
+// Records every invalidated window into the next snapshot. While the render thread has not yet taken
+// the previous snapshot, nothing is recorded and the windows stay invalidated, so no damage is ever lost
+// and this thread never waits for the render thread.
+//
+void Context::p_publish_frame()
+{
+    if (!m_internal->snapshots.is_consumed())
+        return;
+
+    MAPLE_TRACE_SCOPE("Context::p_publish_frame", "mainloop");
+
+    auto& snapshot = m_internal->snapshots.get_write_buffer();
+    snapshot.windows.clear();
+
+    // the window waiting for vertical blank is the last one drawn without an explicit swap interval
+
+    std::optional<std::size_t> vsync;
+    auto record = [&](const std::shared_ptr<Window>& window_)
+    {
+        // a window that is only polling collects its readbacks and fences without counting as a frame
+        bool is_invalidated = window_->p_is_invalidated();
+        if (!is_invalidated && !window_->p_is_polling())
+        {
+            m_statistics.skipped_frames++;
+            return;
+        }
+
+        std::size_t index = snapshot.windows.size();
+        if (snapshot.frames.size() <= index)
+            snapshot.frames.resize(index + 1);
+
+        auto& frame = snapshot.frames[index];
+        if (!window_->p_record(frame))
+        {
+            if (is_invalidated)
+                m_statistics.skipped_frames++;
+            return;
+        }
+
+        if (!frame.is_drawn)
+        {
+            if (is_invalidated)
+                m_statistics.skipped_frames++;
+        }
+        else
+        {
+            if (frame.is_swap_managed)
+                vsync = index;
+            m_statistics.drawn_frames++;
+        }
+        snapshot.windows.push_back(window_);
+    };
+
+    for (auto& window : m_internal->windows)
+        record(window);
+
+    if (snapshot.windows.empty())
+        return;
+
+    if (vsync)
+    {
+        snapshot.frames[*vsync].swap_interval = 1;
+        std::rotate(snapshot.windows.begin() + *vsync, snapshot.windows.begin() + *vsync + 1, snapshot.windows.end());
+        std::rotate(snapshot.frames.begin() + *vsync, snapshot.frames.begin() + *vsync + 1,
+                    snapshot.frames.begin() + snapshot.windows.size());
+    }
+
+    snapshot.generation = m_internal->published_generation.load() + 1;
+    for (auto& window : snapshot.windows)
+        window->p_set_generation(snapshot.generation);
+
+    MAPLE_INSTRUMENT(
+        snapshot.timing = m_internal->pending_timing;
+        snapshot.timing.frame = m_internal->frame_counter++;
+        m_internal->pending_timing = FrameRecord{};
+        for (auto& frame : snapshot.frames)
+            frame.timing.frame = snapshot.timing.frame;
+    )
+
+    m_internal->snapshots.publish();
+    m_internal->published_generation.store(snapshot.generation, std::memory_order_release);
+    m_internal->published_generation.notify_one();
+}
+
+//
+// Draws every published snapshot. The thread running mainloop is woken once a snapshot is taken,
+// so it can record the next one while this one is drawn, and once it is drawn, so closed windows can be destroyed.
+//
+void Context::p_render_thread_main()
+{
+    MAPLE_INSTRUMENT(Tracer::set_thread_name("render thread");)
+
+    std::uint64_t seen = 0;
+    while (true)
+    {
+        m_internal->published_generation.wait(seen, std::memory_order_acquire);
+        seen = m_internal->published_generation.load(std::memory_order_acquire);
+        if (m_internal->is_render_thread_stopping)
+            break;
+
+        if (!m_internal->snapshots.acquire())
+            continue;
+        if (!m_prop.is_headless)
+            glfwPostEmptyEvent();
+
+        auto& snapshot = m_internal->snapshots.get_read_buffer();
+        for (std::size_t i = 0; i < snapshot.windows.size(); i++)
+        {
+            snapshot.windows[i]->p_render(snapshot.frames[i]);
+            MAPLE_INSTRUMENT(
+                if (snapshot.frames[i].is_drawn)
+                {
+                    snapshot.timing.merge(snapshot.frames[i].timing);
+                    snapshot.timing.window_count++;
+                }
+            )
+        }
+        m_internal->shared_surface->release_current();
+        MAPLE_INSTRUMENT(
+            if (snapshot.timing.window_count > 0)
+                m_internal->timeline->push(snapshot.timing);
+        )
+
+        m_internal->rendered_generation.store(snapshot.generation, std::memory_order_release);
+        m_internal->rendered_generation.notify_all();
+        if (!m_prop.is_headless)
+            glfwPostEmptyEvent();
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
-                   maple::configuration::opengl_version_major);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
-                   maple::configuration::opengl_version_major);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+Context::Context(const ContextProperties& props_)
+    : m_prop{ props_ },
+      m_internal{ std::make_shared<InternalData>() }
+{
+    // setup up shared opengl context
 
-    m_internal->shared_gl_context = glfwCreateWindow(100, 100,
-                                                     "", nullptr, nullptr);
-    if (!m_internal->shared_gl_context)
-        throw std::runtime_error("void Context::Context(): "
-                                 "Failed to create window. glfwCreateWindow()");
+    if (m_prop.is_headless)
+        m_internal->shared_surface = platform::Surface::create_headless(Size{}, nullptr);
+    else
+        m_internal->shared_surface = platform::Surface::create_window(Size{ .width = 100, .height = 100 },
+                                                                      "", nullptr);
 
-    glfwMakeContextCurrent(m_internal->shared_gl_context);
+    m_internal->shared_surface->make_current();
     out(glGetString(GL_RENDERER));
 
-    m_internal->renderer_shared_objects = internal_renderer.generate_shared_objects(m_internal->shared_gl_context);
+    if (!m_prop.shader_cache_directory.empty())
+        m_internal->program_cache = gl::ProgramBinaryCache::create(m_prop.shader_cache_directory);
+
+    m_internal->renderer_shared_objects = internal_renderer.generate_shared_objects(*m_internal->shared_surface,
+                                                                                    m_internal->program_cache);
+
+    std::size_t core_count = std::max(std::thread::hardware_concurrency(), 1u);
+    m_internal->job_system = JobSystem::create(m_prop.worker_count.value_or(core_count - 1));
 }
 
 Context::~Context()
 {
+    p_stop_render_thread();
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -367,8 +757,52 @@ Context::~Context()
 struct Window::InternalData
 {
     std::shared_ptr<Context>& context;
-    GLFWwindow* handle{ nullptr };
-    InternalRenderer::WindowStates renderer_window_states;
+    std::unique_ptr<platform::Surface> surface{ nullptr };
+    InternalRenderer::WindowStates renderer_window_states{};
+
+    std::shared_ptr<maple::Frame> root{ maple::Frame::create(nullptr) };
+    event_type::WindowPaint paint_callback{ nullptr };
+    event_type::WindowCloseAttempt close_attempt_callback{ nullptr };
+    Signal<void()> close_signal{};
+    bool is_close_forced{ false };
+
+    // events queued since the last dispatch, and the events being dispatched,
+    // kept apart so a callback can post new events
+    InputQueue input_queue{};
+    InputQueue dispatched_input{};
+    Signal<void(const InputEvent&)> input_signal{};
+
+    // arrival times of dispatched events that invalidated the window, until a frame is recorded
+    std::vector<InputEvent::Clock::time_point> unshown_input_times{};
+
+    DamageRegion damage{};
+    std::uint64_t invalidation_count{ 0 };
+    Size last_viewport{};
+    std::uint64_t generation{ 0 };
+    Frame frame{};
+
+    // captures not yet recorded, and one batch per recorded frame whose pixels are still on their way
+    std::vector<event_type::WindowCapture> capture_requests{};
+    std::vector<std::vector<event_type::WindowCapture>> capture_batches{};
+
+    // only touched by the thread drawing the window
+
+    std::optional<int> applied_swap_interval{};
+
+    // input times of every swapped frame whose fence has not signaled yet, oldest first
+    std::vector<std::vector<InputEvent::Clock::time_point>> unfinished_input_times{};
+
+    // set by the thread drawing the window while it has unfinished input times, which keeps the window
+    // scheduled so the fences are polled even when nothing is invalidated
+    std::atomic<bool> has_unfinished_input{ false };
+
+    // filled by the thread drawing the window, emptied by the thread recording it
+
+    std::mutex capture_mutex;
+    std::vector<Image> captured_images{};
+
+    LatencyRecorder swap_latency{};
+    LatencyRecorder gpu_latency{};
 };
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -412,30 +846,76 @@ std::shared_ptr<Window> Window::create(std::shared_ptr<Context>& context_)
 
 Window::Window(std::shared_ptr<Context>& context_, const WindowProperties& props_)
     : m_prop{ props_ },
-      m_internal{ std::make_shared<InternalData>(InternalData{ .context = context_, .handle = nullptr }) }
+      m_internal{ std::make_shared<InternalData>(context_) }
 {
+    m_internal->damage.add_all();
+
     // create window
 
-    m_internal->handle = glfwCreateWindow(m_prop.size.width, m_prop.size.height,
-                                          m_prop.title.c_str(),
-                                          nullptr,
-                                          context_->m_internal->shared_gl_context);
-    if (!m_internal->handle)
-        throw std::runtime_error("void Window::Window(): "
-                                 "Failed to create window. glfwCreateWindow()");
+    auto& shared_surface = *context_->m_internal->shared_surface;
+    if (context_->m_prop.is_headless)
+        m_internal->surface = platform::Surface::create_headless(m_prop.size, &shared_surface);
+    else
+        m_internal->surface = platform::Surface::create_window(m_prop.size, m_prop.title, &shared_surface);
 
     // set callbacks
+    // resizing and exposing the window are the only events that need a redraw without the user asking for one,
+    // every other event is only queued until the next dispatch
 
-    glfwSetFramebufferSizeCallback(m_internal->handle, [](GLFWwindow* handle_, int width_, int height_)
-        {
-            glViewport(0, 0, width_, height_);
-        });
+    if (GLFWwindow* handle = m_internal->surface->get_glfw_handle())
+    {
+        glfwSetWindowUserPointer(handle, this);
+        glfwSetFramebufferSizeCallback(handle, [](GLFWwindow* handle_, int width_, int height_)
+            {
+                auto* window = static_cast<Window*>(glfwGetWindowUserPointer(handle_));
+                window->invalidate();
+                window->post_input(InputEvent{ .type = InputEventType::framebuffer_resize,
+                                               .size = Size{ .width = width_, .height = height_ } });
+            });
+        glfwSetWindowRefreshCallback(handle, [](GLFWwindow* handle_)
+            {
+                static_cast<Window*>(glfwGetWindowUserPointer(handle_))->invalidate();
+            });
+        glfwSetCursorPosCallback(handle, [](GLFWwindow* handle_, double x_, double y_)
+            {
+                auto* window = static_cast<Window*>(glfwGetWindowUserPointer(handle_));
+                window->post_input(InputEvent{ .type = InputEventType::cursor_move, .x = x_, .y = y_ });
+            });
+        glfwSetScrollCallback(handle, [](GLFWwindow* handle_, double x_, double y_)
+            {
+                auto* window = static_cast<Window*>(glfwGetWindowUserPointer(handle_));
+                window->post_input(InputEvent{ .type = InputEventType::scroll, .x = x_, .y = y_ });
+            });
+        glfwSetMouseButtonCallback(handle, [](GLFWwindow* handle_, int button_, int action_, int mods_)
+            {
+                auto* window = static_cast<Window*>(glfwGetWindowUserPointer(handle_));
+                window->post_input(InputEvent{ .type   = InputEventType::mouse_button,
+                                               .code   = button_,
+                                               .action = action_,
+                                               .mods   = mods_ });
+            });
+        glfwSetKeyCallback(handle, [](GLFWwindow* handle_, int key_, int scancode_, int action_, int mods_)
+            {
+                auto* window = static_cast<Window*>(glfwGetWindowUserPointer(handle_));
+                window->post_input(InputEvent{ .type     = InputEventType::key,
+                                               .code     = key_,
+                                               .scancode = scancode_,
+                                               .action   = action_,
+                                               .mods     = mods_ });
+            });
+        glfwSetCharCallback(handle, [](GLFWwindow* handle_, unsigned int codepoint_)
+            {
+                auto* window = static_cast<Window*>(glfwGetWindowUserPointer(handle_));
+                window->post_input(InputEvent{ .type = InputEventType::character, .codepoint = codepoint_ });
+            });
+    }
 
     // set opengl context states for rendering
 
     m_internal->renderer_window_states
         = internal_renderer.generate_window_states(context_->m_internal->renderer_shared_objects,
-                                                   m_internal->handle);
+                                                   *m_internal->surface);
+    m_internal->surface->release_current();
 }
 
 Window::~Window()
@@ -444,33 +924,507 @@ Window::~Window()
 
 // --------------------------------------------------------------------------------------------------------------------
 
+//
+// The widget tree of the window. The root always covers the whole framebuffer, and is drawn
+// after the paint callback. Changes to the tree redraw only the parts of the window they touch.
+//
+std::shared_ptr<maple::Frame> Window::get_root() const
+{
+    return m_internal->root;
+}
+
+void Window::on_paint(event_type::WindowPaint callback_)
+{
+    m_internal->paint_callback = std::move(callback_);
+    invalidate();
+}
+
+//
+// Called when the user asks to close the window. Returning false keeps the window open.
+// Closing the window with close() does not ask.
+//
+void Window::on_close_attempt(event_type::WindowCloseAttempt callback_)
+{
+    m_internal->close_attempt_callback = std::move(callback_);
+}
+
+//
+// Every connected callback is called once the close is approved, while the window can still be drawn to.
+//
+Signal<void()>::Connection Window::on_close(event_type::WindowClose callback_)
+{
+    return m_internal->close_signal.connect(std::move(callback_));
+}
+
+void Window::disconnect_close(Signal<void()>::Connection connection_)
+{
+    m_internal->close_signal.disconnect(connection_);
+}
+
+//
+// Every connected callback is called for every event, in the order the events arrived,
+// once per Context::draw before any window is drawn.
+//
+Signal<void(const InputEvent&)>::Connection Window::on_input(event_type::WindowInput callback_)
+{
+    return m_internal->input_signal.connect(std::move(callback_));
+}
+
+void Window::disconnect_input(Signal<void(const InputEvent&)>::Connection connection_)
+{
+    m_internal->input_signal.disconnect(connection_);
+}
+
+//
+// Queues an event as if it came from the platform. Headless windows receive no other input.
+// An event without a time is stamped now.
+//
+void Window::post_input(const InputEvent& event_)
+{
+    InputEvent event = event_;
+    if (event.time == InputEvent::Clock::time_point{})
+        event.time = InputEvent::Clock::now();
+    m_internal->input_queue.push(event);
+}
+
+//
+// The raw events merged into an event, oldest first. Only valid while the event is being dispatched.
+//
+std::span<const InputEvent> Window::get_input_history(const InputEvent& event_) const
+{
+    return m_internal->dispatched_input.get_history(event_);
+}
+
+//
+// Stays empty unless the library was built with MAPLE_ENABLE_INSTRUMENTATION.
+//
+InputLatency Window::get_input_latency() const
+{
+    return InputLatency{ .swap = m_internal->swap_latency.get_percentiles(),
+                         .gpu  = m_internal->gpu_latency.get_percentiles() };
+}
+
+void Window::reset_input_latency()
+{
+    m_internal->swap_latency.clear();
+    m_internal->gpu_latency.clear();
+}
+
+//
+// Requests a redraw on the next Context::draw. Invalidating several times before that draws only once.
+// Invalidating a rectangle redraws only that part of the window, in framebuffer pixels.
+//
+void Window::invalidate()
+{
+    m_internal->damage.add_all();
+    m_internal->invalidation_count++;
+}
+
+void Window::invalidate(const Rect& rect_)
+{
+    m_internal->damage.add(rect_);
+    m_internal->invalidation_count++;
+}
+
+void Window::close()
+{
+    if (!m_internal->surface)
+        return;
+
+    m_internal->is_close_forced = true;
+    m_internal->surface->request_close();
+}
+
+Size Window::get_framebuffer_size() const
+{
+    if (!m_internal->surface)
+        return Size{};
+
+    return m_internal->surface->get_framebuffer_size();
+}
+
+//
+// Reads back the last drawn frame as tightly packed RGBA8 rows, from top to bottom.
+// This waits for the GPU to finish drawing, and cannot be used while a render thread owns the contexts.
+//
+std::vector<std::uint8_t> Window::read_pixels()
+{
+    if (!m_internal->surface)
+        throw std::runtime_error("std::vector<std::uint8_t> Window::read_pixels(): "
+                                 "The window is already closed.");
+    if (m_internal->context->m_internal->render_thread.joinable())
+        throw std::runtime_error("std::vector<std::uint8_t> Window::read_pixels(): "
+                                 "The render thread owns the OpenGL context.");
+
+    auto& surface = *m_internal->surface;
+    surface.make_current();
+
+    Size size = surface.get_framebuffer_size();
+    std::size_t row_size = static_cast<std::size_t>(size.width) * 4;
+    std::vector<std::uint8_t> pixels(row_size * size.height);
+
+    auto& states = m_internal->renderer_window_states;
+    unsigned int framebuffer = states.back_framebuffer ? states.back_framebuffer->get_id()
+                                                       : surface.get_framebuffer_id();
+    surface.get_state_tracker().bind_framebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    if (framebuffer == 0)
+        glReadBuffer(GL_FRONT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    for (int y = 0; y < size.height / 2; y++)
+        std::swap_ranges(pixels.begin() + y * row_size,
+                         pixels.begin() + (y + 1) * row_size,
+                         pixels.begin() + (size.height - 1 - y) * row_size);
+
+    return pixels;
+}
+
+//
+// Reads back the next frame drawn, without stalling the pipeline, and passes it to the callback
+// one or two frames later on the thread running mainloop. The window keeps drawing until the image
+// has been delivered. Captures still pending when the window closes are dropped.
+//
+void Window::capture(event_type::WindowCapture callback_)
+{
+    m_internal->capture_requests.push_back(std::move(callback_));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
 void Window::p_show()
 {
-    glfwShowWindow(m_internal->handle);
+    m_internal->surface->show();
+    invalidate();
 }
 
-void Window::p_draw()
+//
+// The frame a window records into and draws from when there is no render thread.
+//
+Window::Frame& Window::p_get_frame()
 {
-    glfwMakeContextCurrent(m_internal->handle);
+    return m_internal->frame;
+}
 
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+//
+// Draws the frame last recorded into p_get_frame.
+//
+void Window::p_draw([[maybe_unused]] FrameRecord& record_)
+{
+    MAPLE_TRACE_SCOPE("Window::p_draw", "window");
+
+    auto& frame = m_internal->frame;
+    MAPLE_INSTRUMENT(frame.timing.frame = record_.frame;)
+    p_render(frame);
+
+    MAPLE_INSTRUMENT(
+        if (frame.is_drawn)
+        {
+            record_.merge(frame.timing);
+            record_.window_count++;
+        }
+    )
+}
+
+//
+// Runs the paint callback and records what it painted. Returns false when there is nothing to draw,
+// and nothing of earlier frames left to collect.
+// The damage is taken before painting, so invalidating from a paint callback schedules another frame.
+//
+bool Window::p_record(Frame& frame_)
+{
+    MAPLE_TRACE_SCOPE("Window::p_record", "window");
+    MAPLE_INSTRUMENT(frame_.timing = FrameRecord{};)
+
+    auto& root = *m_internal->root;
+    Size viewport = m_internal->surface->get_framebuffer_size();
+    {
+        MAPLE_TRACE_SCOPE("Window::layout", "window");
+        MAPLE_INSTRUMENT(PhaseTimer timer(frame_.timing, FramePhase::layout);)
+        root.set_rect(Rect{ .x = 0, .y = 0, .width = viewport.width, .height = viewport.height });
+        root.layout(m_internal->context->m_internal->job_system.get());
+        root.update(m_internal->damage);
+    }
+
+    MAPLE_INSTRUMENT(PhaseTimer timer(frame_.timing, FramePhase::command_generation);)
+    p_deliver_captures();
+
+    frame_.damage = std::move(m_internal->damage);
+    m_internal->damage.clear();
+    frame_.commands.clear();
+    frame_.swap_interval = m_prop.swap_interval.value_or(0);
+    frame_.is_swap_managed = !m_prop.swap_interval;
+    frame_.input_times.swap(m_internal->unshown_input_times);
+    m_internal->unshown_input_times.clear();
+
+    frame_.viewport = viewport;
+    if (viewport.width <= 0 || viewport.height <= 0)
+    {
+        for (auto& callback : std::exchange(m_internal->capture_requests, {}))
+            callback(Image{});
+        return false;
+    }
+
+    if (viewport.width != m_internal->last_viewport.width || viewport.height != m_internal->last_viewport.height)
+    {
+        frame_.damage.add_all();
+        m_internal->last_viewport = viewport;
+    }
+    frame_.damage.clip(viewport);
+
+    // damage entirely outside the framebuffer shows nowhere, so there is nothing to blit or swap,
+    // and unless a capture needs this frame, the frame only collects readbacks and fences of earlier frames
+
+    frame_.is_captured = !m_internal->capture_requests.empty();
+    if (frame_.is_captured)
+        m_internal->capture_batches.push_back(std::exchange(m_internal->capture_requests, {}));
+
+    frame_.is_drawn = !frame_.damage.is_empty() || frame_.is_captured;
+    if (!frame_.is_drawn)
+    {
+        frame_.input_times.clear();
+        return !m_internal->capture_batches.empty() || m_internal->has_unfinished_input.load();
+    }
+
+    auto& shared_objects = m_internal->context->m_internal->renderer_shared_objects;
+    Painter painter(frame_.commands, shared_objects.rect_shader, viewport, frame_.damage);
+    if (m_internal->paint_callback)
+        m_internal->paint_callback(painter);
+    else if (root.get_children().empty())
+        painter.fill_rect(Rect{ .x      = viewport.width / 4,  .y      = viewport.height / 4,
+                                .width  = viewport.width / 2,  .height = viewport.height / 2 },
+                          Color{ .r = 0.3f, .g = 0.4f, .b = 0.5f, .a = 1.0f });
+    root.draw(painter, frame_.damage);
+
+    return true;
+}
+
+//
+// Only the damaged rectangles are cleared and redrawn, everything else is kept from the previous frame.
+// In builds with instrumentation, every pass is timed on the GPU, and the results of earlier frames
+// that completed by now are added to the timeline.
+//
+void Window::p_render(Frame& frame_)
+{
+    MAPLE_TRACE_SCOPE("Window::p_render", "render");
+
+    auto& surface = *m_internal->surface;
+    auto& states = m_internal->renderer_window_states;
+    {
+        MAPLE_INSTRUMENT(PhaseTimer timer(frame_.timing, FramePhase::gpu_submit);)
+
+        surface.make_current();
+
+        MAPLE_INSTRUMENT(
+            p_collect_gpu_times();
+            p_collect_input_latency();
+        )
+
+        if (states.pixel_reader && states.pixel_reader->is_pending())
+        {
+            std::vector<Image> images;
+            if (states.pixel_reader->collect(images) > 0)
+            {
+                std::lock_guard lock(m_internal->capture_mutex);
+                std::ranges::move(images, std::back_inserter(m_internal->captured_images));
+            }
+        }
+
+        if (!frame_.is_drawn)
+            return;
+        MAPLE_INSTRUMENT(states.gpu_timer->begin_frame(frame_.timing.frame);)
+
+        if (m_internal->applied_swap_interval != frame_.swap_interval)
+        {
+            surface.set_swap_interval(frame_.swap_interval);
+            m_internal->applied_swap_interval = frame_.swap_interval;
+        }
+
+        unsigned int target = internal_renderer.prepare_render_target(states, surface, frame_.viewport);
+        surface.get_state_tracker().bind_framebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, frame_.viewport.width, frame_.viewport.height);
+
+        MAPLE_INSTRUMENT(states.gpu_timer->begin_pass(static_cast<unsigned int>(GpuPass::clear));)
+        internal_renderer.clear_damage(frame_.damage, frame_.viewport);
+        MAPLE_INSTRUMENT(states.gpu_timer->end_pass();)
+
+        MAPLE_INSTRUMENT(states.gpu_timer->begin_pass(static_cast<unsigned int>(GpuPass::rects));)
+        auto& shared_objects = m_internal->context->m_internal->renderer_shared_objects;
+        internal_renderer.draw_rects(shared_objects, states, frame_.viewport, frame_.commands, frame_.damage);
+        MAPLE_INSTRUMENT(
+            frame_.timing.draw_calls = shared_objects.rect_batch->get_statistics().draw_calls;
+            states.gpu_timer->end_pass();
+        )
+
+        if (frame_.is_captured)
+        {
+            if (!states.pixel_reader)
+                states.pixel_reader = gl::PixelReader::create();
+            states.pixel_reader->read(target, frame_.viewport);
+        }
+    }
+
+    MAPLE_INSTRUMENT(PhaseTimer timer(frame_.timing, FramePhase::swap);)
+    MAPLE_INSTRUMENT(states.gpu_timer->begin_pass(static_cast<unsigned int>(GpuPass::blit));)
+    internal_renderer.blit_to_surface(states, surface);
+    MAPLE_INSTRUMENT(states.gpu_timer->end_frame();)
+    {
+        MAPLE_TRACE_SCOPE("swap_buffers", "render");
+        surface.swap_buffers();
+    }
 
+    MAPLE_INSTRUMENT(
+        if (!frame_.input_times.empty())
+        {
+            auto swapped = InputEvent::Clock::now();
+            for (auto& time : frame_.input_times)
+                m_internal->swap_latency.add(swapped - time);
 
-    internal_renderer.draw_quad(m_internal->context->m_internal->renderer_shared_objects,
-                                m_internal->renderer_window_states);
+            states.fence_tracker->insert(frame_.timing.frame);
+            m_internal->unfinished_input_times.push_back(std::move(frame_.input_times));
+            m_internal->has_unfinished_input = true;
+        }
+    )
+}
 
-    glfwSwapBuffers(m_internal->handle);
+//
+// Passes every image read back by now to the captures of the frame it was read from, oldest frame first.
+//
+void Window::p_deliver_captures()
+{
+    std::vector<Image> images;
+    {
+        std::lock_guard lock(m_internal->capture_mutex);
+        images.swap(m_internal->captured_images);
+    }
+
+    for (auto& image : images)
+    {
+        auto callbacks = std::move(m_internal->capture_batches.front());
+        m_internal->capture_batches.erase(m_internal->capture_batches.begin());
+        for (auto& callback : callbacks)
+            callback(image);
+    }
 }
 
+#ifdef MAPLE_ENABLE_INSTRUMENTATION
+//
+// Never waits for the GPU. Must be called with the window's context current, since queries are not shared.
+//
+void Window::p_collect_gpu_times()
+{
+    thread_local std::vector<gl::TimerQueryPool::Result> results;
+    results.clear();
+    m_internal->renderer_window_states.gpu_timer->collect(results);
+
+    auto& timeline = *m_internal->context->m_internal->timeline;
+    for (auto& result : results)
+        timeline.add_gpu_time(result.frame, static_cast<GpuPass>(result.pass), result.duration);
+}
+
+//
+// Fences signal in the order they were inserted, so the oldest input times belong to the first result.
+//
+void Window::p_collect_input_latency()
+{
+    thread_local std::vector<gl::FenceTracker::Result> results;
+    results.clear();
+    m_internal->renderer_window_states.fence_tracker->collect(results);
+
+    auto& unfinished = m_internal->unfinished_input_times;
+    for (std::size_t i = 0; i < results.size(); i++)
+        for (auto& time : unfinished[i])
+            m_internal->gpu_latency.add(results[i].time - time);
+    unfinished.erase(unfinished.begin(), unfinished.begin() + results.size());
+    m_internal->has_unfinished_input = !unfinished.empty();
+}
+#endif
+
+//
+// Per-context objects are released with the window's own context current, before the context is destroyed.
+//
 void Window::p_close()
 {
-    glfwDestroyWindow(m_internal->handle);
+    m_internal->surface->make_current();
+    m_internal->renderer_window_states = InternalRenderer::WindowStates{};
+    m_internal->surface.reset();
+}
+
+void Window::p_dispatch_input()
+{
+    if (m_internal->input_queue.is_empty())
+        return;
+
+    // the damage accumulates over the frame, and widget changes only become damage when the frame is recorded,
+    // so whether an event changed anything is told by the invalidations made while it was dispatched
+
+    [[maybe_unused]] auto get_change_count = [this]()
+        {
+            return m_internal->invalidation_count + m_internal->root->get_change_count();
+        };
+
+    std::swap(m_internal->input_queue, m_internal->dispatched_input);
+    for (auto& event : m_internal->dispatched_input.get_events())
+    {
+        MAPLE_INSTRUMENT(std::uint64_t changes = get_change_count();)
+        m_internal->input_signal.emit(event);
+
+        // an event that leaves the window as it was shows nowhere, and has no latency
+        // coalesced events count from their oldest raw event, when the user started moving
+        MAPLE_INSTRUMENT(
+            if (get_change_count() != changes)
+                m_internal->unshown_input_times.push_back(m_internal->dispatched_input.get_history(event).front().time);
+        )
+    }
+    m_internal->dispatched_input.clear();
 }
 
 bool Window::p_is_close_approved()
 {
-    return static_cast<bool>(glfwWindowShouldClose(m_internal->handle));
+    if (!m_internal->surface->is_close_requested())
+        return false;
+
+    if (!m_internal->is_close_forced && m_internal->close_attempt_callback && !m_internal->close_attempt_callback())
+    {
+        m_internal->surface->cancel_close();
+        return false;
+    }
+
+    m_internal->close_signal.emit();
+    return true;
+}
+
+//
+// Whether the window has something new to draw. Outstanding readbacks and fences do not count,
+// they only make mainloop poll, so a loop waiting for them sleeps between polls instead of spinning.
+//
+bool Window::p_is_invalidated() const
+{
+    return !m_internal->damage.is_empty() || !m_internal->capture_requests.empty()
+                                          || !m_internal->input_queue.is_empty()
+                                          || m_internal->root->has_changes();
+}
+
+//
+// Frames whose fences are outstanding are polled again soon, even if no event arrives meanwhile,
+// so the GPU latency of input does not include the time the loop spent idle.
+//
+bool Window::p_is_polling() const
+{
+    return m_internal->has_unfinished_input.load() || !m_internal->capture_batches.empty();
+}
+
+//
+// The generation of the last render snapshot the window was recorded into.
+//
+std::uint64_t Window::p_get_generation() const
+{
+    return m_internal->generation;
+}
+
+void Window::p_set_generation(std::uint64_t generation_)
+{
+    m_internal->generation = generation_;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,159 @@
+#include "damage_region.h"
+
+
+
+namespace maple
+{
+
+namespace
+{
+
+bool is_empty_rect(const Rect& rect_)
+{
+    return rect_.width <= 0 || rect_.height <= 0;
+}
+
+long long area(const Rect& rect_)
+{
+    return static_cast<long long>(rect_.width) * rect_.height;
+}
+
+bool overlaps(const Rect& a_, const Rect& b_)
+{
+    return a_.x < b_.x + b_.width && b_.x < a_.x + a_.width
+        && a_.y < b_.y + b_.height && b_.y < a_.y + a_.height;
+}
+
+bool contains(const Rect& outer_, const Rect& inner_)
+{
+    return outer_.x <= inner_.x && inner_.x + inner_.width <= outer_.x + outer_.width
+        && outer_.y <= inner_.y && inner_.y + inner_.height <= outer_.y + outer_.height;
+}
+
+Rect bounding_box(const Rect& a_, const Rect& b_)
+{
+    int left   = std::min(a_.x, b_.x);
+    int top    = std::min(a_.y, b_.y);
+    int right  = std::max(a_.x + a_.width, b_.x + b_.width);
+    int bottom = std::max(a_.y + a_.height, b_.y + b_.height);
+    return Rect{ .x = left, .y = top, .width = right - left, .height = bottom - top };
+}
+
+//
+// Pixels of the bounding box that belong to neither rectangle. Negative when they overlap.
+//
+long long merge_cost(const Rect& a_, const Rect& b_)
+{
+    return area(bounding_box(a_, b_)) - area(a_) - area(b_);
+}
+
+}
+
+
+
+// ====================================================================================================================
+//     CLASS: DamageRegion
+// ====================================================================================================================
+
+void DamageRegion::add(const Rect& rect_)
+{
+    if (m_is_all || is_empty_rect(rect_))
+        return;
+
+    Rect rect = rect_;
+    for (std::size_t i = 0; i < m_rects.size();)
+    {
+        if (contains(m_rects[i], rect))
+            return;
+
+        if (overlaps(m_rects[i], rect) || merge_cost(m_rects[i], rect) <= 0)
+        {
+            // the merged rectangle may now reach others, so start over
+            rect = bounding_box(m_rects[i], rect);
+            m_rects.erase(m_rects.begin() + i);
+            i = 0;
+        }
+        else
+            i++;
+    }
+    m_rects.push_back(rect);
+
+    if (m_rects.size() <= max_rect_count)
+        return;
+
+    std::size_t best_a = 0, best_b = 1;
+    for (std::size_t a = 0; a < m_rects.size(); a++)
+        for (std::size_t b = a + 1; b < m_rects.size(); b++)
+            if (merge_cost(m_rects[a], m_rects[b]) < merge_cost(m_rects[best_a], m_rects[best_b]))
+                best_a = a, best_b = b;
+
+    Rect merged = bounding_box(m_rects[best_a], m_rects[best_b]);
+    m_rects.erase(m_rects.begin() + best_b);
+    m_rects.erase(m_rects.begin() + best_a);
+    add(merged);
+}
+
+//
+// Damages the whole framebuffer, whatever its size turns out to be when the region is clipped.
+//
+void DamageRegion::add_all()
+{
+    m_is_all = true;
+    m_rects.clear();
+}
+
+//
+// Limits the region to a framebuffer of the given size. Called right before drawing.
+//
+void DamageRegion::clip(const Size& bounds_)
+{
+    Rect bounds{ .x = 0, .y = 0, .width = bounds_.width, .height = bounds_.height };
+    if (m_is_all)
+    {
+        m_is_all = false;
+        m_rects.clear();
+        add(bounds);
+        return;
+    }
+
+    for (auto& rect : m_rects)
+    {
+        int left   = std::max(rect.x, 0);
+        int top    = std::max(rect.y, 0);
+        int right  = std::min(rect.x + rect.width, bounds.width);
+        int bottom = std::min(rect.y + rect.height, bounds.height);
+        rect = Rect{ .x = left, .y = top, .width = right - left, .height = bottom - top };
+    }
+    std::erase_if(m_rects, is_empty_rect);
+}
+
+void DamageRegion::clear()
+{
+    m_is_all = false;
+    m_rects.clear();
+}
+
+bool DamageRegion::is_empty() const
+{
+    return !m_is_all && m_rects.empty();
+}
+
+bool DamageRegion::intersects(const Rect& rect_) const
+{
+    if (m_is_all)
+        return true;
+
+    for (auto& rect : m_rects)
+        if (overlaps(rect, rect_))
+            return true;
+    return false;
+}
+
+const std::vector<Rect>& DamageRegion::get_rects() const
+{
+    return m_rects;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
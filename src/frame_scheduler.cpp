@@ -0,0 +1,219 @@
+#include "frame_scheduler.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//     CLASS: FrameScheduler
+// ====================================================================================================================
+
+std::shared_ptr<FrameScheduler> FrameScheduler::create()
+{
+    struct MakeSharedEnabler : public FrameScheduler {};
+    return std::make_shared<MakeSharedEnabler>();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+FrameScheduler::FrameScheduler()
+    : m_next_id{ 1 },
+      m_firing{ 0 },
+      m_is_firing_cancelled{ false },
+      m_epoch{ Clock::now() },
+      m_frame_interval{ std::chrono::microseconds(16667) },
+      m_slack{ std::chrono::milliseconds(1) }
+{
+}
+
+FrameScheduler::~FrameScheduler()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+FrameScheduler::TimerId FrameScheduler::add_timer(Clock::duration delay_, event_type::Timer callback_)
+{
+    return p_add(Timer{ .deadline = Clock::now() + delay_, .callback = std::move(callback_) });
+}
+
+//
+// Repeats until cancelled. Deadlines advance by the interval without drifting,
+// and intervals that were missed entirely are skipped rather than fired in a burst.
+//
+FrameScheduler::TimerId FrameScheduler::add_repeating_timer(Clock::duration interval_, event_type::Timer callback_)
+{
+    if (interval_ <= Clock::duration::zero())
+        throw std::runtime_error("void FrameScheduler::add_repeating_timer(): The interval must be positive.");
+
+    return p_add(Timer{ .deadline = Clock::now() + interval_, .interval = interval_,
+                        .callback = std::move(callback_) });
+}
+
+//
+// Calls the callback once per frame with the progress from 0 to 1. The last call always passes exactly 1.
+//
+FrameScheduler::TimerId FrameScheduler::add_animation(Clock::duration duration_, event_type::Animation callback_)
+{
+    auto now = Clock::now();
+    return p_add(Timer{ .deadline = p_next_frame(now), .start = now, .duration = duration_,
+                        .animation = std::move(callback_) });
+}
+
+//
+// Safe to call from inside a callback, including for the timer that is currently firing.
+//
+void FrameScheduler::cancel(TimerId id_)
+{
+    if (id_ == m_firing)
+        m_is_firing_cancelled = true;
+    m_timers.erase(id_);
+}
+
+void FrameScheduler::set_frame_interval(Clock::duration interval_)
+{
+    if (interval_ <= Clock::duration::zero())
+        throw std::runtime_error("void FrameScheduler::set_frame_interval(): The interval must be positive.");
+
+    m_frame_interval = interval_;
+}
+
+void FrameScheduler::set_coalescing_slack(Clock::duration slack_)
+{
+    m_slack = slack_;
+}
+
+std::optional<FrameScheduler::Clock::time_point> FrameScheduler::get_next_deadline()
+{
+    p_drop_cancelled();
+
+    if (m_deadlines.empty())
+        return std::nullopt;
+    return m_deadlines.front().time;
+}
+
+//
+// Fires every timer due within the coalescing slack of now_, and returns how many fired.
+// Timers added by a callback are not fired before the next call, even when they are already due.
+//
+std::size_t FrameScheduler::run_due(Clock::time_point now_)
+{
+    std::vector<TimerId> due;
+    p_drop_cancelled();
+    while (!m_deadlines.empty() && m_deadlines.front().time <= now_ + m_slack)
+    {
+        due.push_back(m_deadlines.front().id);
+        std::pop_heap(m_deadlines.begin(), m_deadlines.end(), p_is_later);
+        m_deadlines.pop_back();
+        p_drop_cancelled();
+    }
+
+    std::size_t fired = 0;
+    for (TimerId id : due)
+    {
+        auto it = m_timers.find(id);
+        if (it == m_timers.end())
+            continue;
+
+        fired++;
+
+        // the callback may add or cancel timers, including itself, so it runs outside of the map
+
+        Timer timer = std::move(it->second);
+        m_timers.erase(it);
+        m_firing = id;
+        m_is_firing_cancelled = false;
+
+        bool is_repeating = false;
+        if (timer.animation)
+        {
+            // fired up to the slack early, in which case the frame boundary or the end counts as reached
+
+            auto elapsed = now_ - timer.start;
+            float progress = elapsed + m_slack >= timer.duration || timer.duration <= Clock::duration::zero()
+                           ? 1.0f
+                           : std::chrono::duration<float>(elapsed) / std::chrono::duration<float>(timer.duration);
+            timer.animation(progress);
+
+            is_repeating = progress < 1.0f;
+            timer.deadline = std::min(p_next_frame(now_ + m_slack), timer.start + timer.duration);
+        }
+        else
+        {
+            timer.callback();
+
+            // fired up to the slack early, so the next deadline lies past both the current one and the slack
+
+            is_repeating = timer.interval > Clock::duration::zero();
+            auto fired_until = std::max(timer.deadline, now_ + m_slack);
+            while (is_repeating && timer.deadline <= fired_until)
+                timer.deadline += timer.interval;
+        }
+
+        m_firing = 0;
+        if (is_repeating && !m_is_firing_cancelled)
+        {
+            m_deadlines.push_back(Deadline{ .time = timer.deadline, .id = id });
+            std::push_heap(m_deadlines.begin(), m_deadlines.end(), p_is_later);
+            m_timers.emplace(id, std::move(timer));
+        }
+    }
+
+    if (fired > 0)
+        m_statistics.wakeups++;
+    m_statistics.fired += fired;
+
+    return fired;
+}
+
+const FrameScheduler::Statistics& FrameScheduler::get_statistics() const
+{
+    return m_statistics;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+FrameScheduler::TimerId FrameScheduler::p_add(Timer timer_)
+{
+    TimerId id = m_next_id++;
+    m_deadlines.push_back(Deadline{ .time = timer_.deadline, .id = id });
+    std::push_heap(m_deadlines.begin(), m_deadlines.end(), p_is_later);
+    m_timers.emplace(id, std::move(timer_));
+    return id;
+}
+
+//
+// Orders the deadline heap so that the earliest deadline is at the front.
+//
+bool FrameScheduler::p_is_later(const Deadline& a_, const Deadline& b_)
+{
+    return a_.time > b_.time;
+}
+
+//
+// The first frame boundary strictly after the given time.
+//
+FrameScheduler::Clock::time_point FrameScheduler::p_next_frame(Clock::time_point after_) const
+{
+    auto frames = (after_ - m_epoch) / m_frame_interval + 1;
+    return m_epoch + frames * m_frame_interval;
+}
+
+//
+// Cancelled timers leave their deadline in the heap. They are removed once they reach the front.
+//
+void FrameScheduler::p_drop_cancelled()
+{
+    while (!m_deadlines.empty() && !m_timers.contains(m_deadlines.front().id))
+    {
+        std::pop_heap(m_deadlines.begin(), m_deadlines.end(), p_is_later);
+        m_deadlines.pop_back();
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,88 @@
+#include "input.h"
+
+
+
+namespace maple
+{
+
+namespace
+{
+
+bool is_coalesced(InputEventType type_)
+{
+    return type_ == InputEventType::cursor_move || type_ == InputEventType::scroll
+                                                || type_ == InputEventType::framebuffer_resize;
+}
+
+}
+
+
+
+// ====================================================================================================================
+//     CLASS: InputQueue
+// ====================================================================================================================
+
+void InputQueue::push(const InputEvent& event_)
+{
+    InputEvent event = event_;
+    event.history_begin = m_history.size();
+    event.history_count = 1;
+    m_history.push_back(event);
+
+    if (m_events.empty() || !is_coalesced(event.type) || m_events.back().type != event.type)
+    {
+        m_events.push_back(event);
+        return;
+    }
+
+    InputEvent& last = m_events.back();
+    if (event.type == InputEventType::scroll)
+    {
+        event.x += last.x;
+        event.y += last.y;
+    }
+    event.history_begin = last.history_begin;
+    event.history_count = last.history_count + 1;
+    last = event;
+}
+
+//
+// Keeps the capacity, so a queue that was flooded once does not allocate again.
+//
+void InputQueue::clear()
+{
+    m_events.clear();
+    m_history.clear();
+}
+
+bool InputQueue::is_empty() const
+{
+    return m_events.empty();
+}
+
+const std::vector<InputEvent>& InputQueue::get_events() const
+{
+    return m_events;
+}
+
+const std::vector<InputEvent>& InputQueue::get_history() const
+{
+    return m_history;
+}
+
+//
+// The raw events merged into an event of this queue, oldest first.
+//
+std::span<const InputEvent> InputQueue::get_history(const InputEvent& event_) const
+{
+    // compared without adding, which could wrap around for an event that never came from a queue
+    if (event_.history_begin > m_history.size() || event_.history_count > m_history.size() - event_.history_begin)
+        throw std::runtime_error("std::span<const InputEvent> InputQueue::get_history(const InputEvent&): "
+                                 "The event is not in this queue.");
+
+    return std::span<const InputEvent>(m_history).subspan(event_.history_begin, event_.history_count);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,260 @@
+#include "instrumentation.h"
+
+#include <cmath>
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//     CLASS: FrameRecord
+// ====================================================================================================================
+
+const char* to_string(FramePhase phase_)
+{
+    switch (phase_)
+    {
+    case FramePhase::event_wait:            return "event_wait";
+    case FramePhase::layout:                return "layout";
+    case FramePhase::command_generation:    return "command_generation";
+    case FramePhase::gpu_submit:            return "gpu_submit";
+    case FramePhase::swap:                  return "swap";
+    default:                                return "unknown";
+    }
+}
+
+const char* to_string(GpuPass pass_)
+{
+    switch (pass_)
+    {
+    case GpuPass::clear:    return "gpu_clear";
+    case GpuPass::rects:    return "gpu_rects";
+    case GpuPass::blit:     return "gpu_blit";
+    default:                return "unknown";
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void FrameRecord::add(FramePhase phase_, std::chrono::nanoseconds duration_)
+{
+    phases[static_cast<std::size_t>(phase_)] += duration_;
+}
+
+void FrameRecord::add(GpuPass pass_, std::chrono::nanoseconds duration_)
+{
+    gpu_passes[static_cast<std::size_t>(pass_)] += duration_;
+}
+
+void FrameRecord::merge(const FrameRecord& other_)
+{
+    draw_calls += other_.draw_calls;
+    for (std::size_t i = 0; i < phases.size(); i++)
+        phases[i] += other_.phases[i];
+    for (std::size_t i = 0; i < gpu_passes.size(); i++)
+        gpu_passes[i] += other_.gpu_passes[i];
+}
+
+std::chrono::nanoseconds FrameRecord::get(FramePhase phase_) const
+{
+    return phases[static_cast<std::size_t>(phase_)];
+}
+
+std::chrono::nanoseconds FrameRecord::get(GpuPass pass_) const
+{
+    return gpu_passes[static_cast<std::size_t>(pass_)];
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+PhaseTimer::PhaseTimer(FrameRecord& record_, FramePhase phase_)
+    : m_record{ record_ },
+      m_phase{ phase_ },
+      m_start{ std::chrono::steady_clock::now() }
+{
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    m_record.add(m_phase, std::chrono::steady_clock::now() - m_start);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+
+
+// ====================================================================================================================
+//     CLASS: FrameTimeline
+// ====================================================================================================================
+
+std::shared_ptr<FrameTimeline> FrameTimeline::create(std::size_t capacity_)
+{
+    struct MakeSharedEnabler : public FrameTimeline
+    {
+        MakeSharedEnabler(std::size_t capacity_)
+            : FrameTimeline(capacity_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(capacity_);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+FrameTimeline::FrameTimeline(std::size_t capacity_)
+    : m_records(std::max<std::size_t>(capacity_, 1)),
+      m_next{ 0 },
+      m_size{ 0 }
+{
+}
+
+FrameTimeline::~FrameTimeline()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Overwrites the oldest record once the ring is full.
+//
+void FrameTimeline::push(const FrameRecord& record_)
+{
+    std::lock_guard lock(m_mutex);
+
+    m_records[m_next] = record_;
+    m_next = (m_next + 1) % m_records.size();
+    m_size = std::min(m_size + 1, m_records.size());
+}
+
+//
+// Adds a GPU time to a frame that was already pushed. Searches from the newest record,
+// since results arrive only a few frames late.
+//
+void FrameTimeline::add_gpu_time(std::uint64_t frame_, GpuPass pass_, std::chrono::nanoseconds duration_)
+{
+    std::lock_guard lock(m_mutex);
+
+    for (std::size_t i = 1; i <= m_size; i++)
+    {
+        auto& record = m_records[(m_next + m_records.size() - i) % m_records.size()];
+        if (record.frame == frame_)
+        {
+            record.add(pass_, duration_);
+            return;
+        }
+        if (record.frame < frame_)
+            return;
+    }
+}
+
+void FrameTimeline::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_next = 0;
+    m_size = 0;
+}
+
+//
+// Returns the records from the oldest to the newest.
+//
+std::vector<FrameRecord> FrameTimeline::get_records() const
+{
+    std::lock_guard lock(m_mutex);
+
+    std::vector<FrameRecord> records;
+    records.reserve(m_size);
+    std::size_t first = (m_next + m_records.size() - m_size) % m_records.size();
+    for (std::size_t i = 0; i < m_size; i++)
+        records.push_back(m_records[(first + i) % m_records.size()]);
+    return records;
+}
+
+std::size_t FrameTimeline::get_capacity() const
+{
+    return m_records.size();
+}
+
+//
+// Writes one line per frame with the time of every phase and GPU pass in milliseconds.
+//
+void FrameTimeline::dump(std::ostream& stream_) const
+{
+    stream_ << "frame windows draw_calls";
+    for (std::size_t i = 0; i < static_cast<std::size_t>(FramePhase::count); i++)
+        stream_ << " " << to_string(static_cast<FramePhase>(i));
+    for (std::size_t i = 0; i < static_cast<std::size_t>(GpuPass::count); i++)
+        stream_ << " " << to_string(static_cast<GpuPass>(i));
+    stream_ << "\n";
+
+    for (auto& record : get_records())
+    {
+        stream_ << record.frame << " " << record.window_count << " " << record.draw_calls;
+        for (auto& phase : record.phases)
+            stream_ << " " << std::chrono::duration<double, std::milli>(phase).count();
+        for (auto& pass : record.gpu_passes)
+            stream_ << " " << std::chrono::duration<double, std::milli>(pass).count();
+        stream_ << "\n";
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+
+
+// ====================================================================================================================
+//     CLASS: LatencyRecorder
+// ====================================================================================================================
+
+LatencyRecorder::LatencyRecorder(std::size_t capacity_)
+    : m_samples(std::max<std::size_t>(capacity_, 1)),
+      m_next{ 0 },
+      m_size{ 0 }
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void LatencyRecorder::add(std::chrono::nanoseconds latency_)
+{
+    std::lock_guard lock(m_mutex);
+
+    m_samples[m_next] = latency_;
+    m_next = (m_next + 1) % m_samples.size();
+    m_size = std::min(m_size + 1, m_samples.size());
+}
+
+void LatencyRecorder::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_next = 0;
+    m_size = 0;
+}
+
+LatencyPercentiles LatencyRecorder::get_percentiles() const
+{
+    std::vector<std::chrono::nanoseconds> samples;
+    {
+        std::lock_guard lock(m_mutex);
+        samples.assign(m_samples.begin(), m_samples.begin() + m_size);
+    }
+    if (samples.empty())
+        return LatencyPercentiles{};
+
+    std::ranges::sort(samples);
+    auto at = [&samples](double percent_)
+        {
+            auto rank = static_cast<std::size_t>(std::ceil(percent_ / 100.0 * samples.size()));
+            return samples[std::clamp<std::size_t>(rank, 1, samples.size()) - 1];
+        };
+
+    return LatencyPercentiles{ .count = samples.size(),
+                               .p50   = at(50.0),
+                               .p90   = at(90.0),
+                               .p99   = at(99.0),
+                               .max   = samples.back() };
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
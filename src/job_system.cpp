@@ -0,0 +1,392 @@
+#include "job_system.h"
+#include "tracing.h"
+
+
+
+namespace maple
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// the job system the current thread works for, and its deque in that system
+thread_local const JobSystem* current_system{ nullptr };
+thread_local std::size_t current_index{ 0 };
+
+// jobs run by waiting within a job are part of its busy time already
+thread_local std::size_t execute_depth{ 0 };
+
+// how often a waiting thread finds nothing to take before it sleeps until a job is queued or finished
+constexpr std::size_t failed_takes_before_sleep = 64;
+
+}
+
+
+
+// ====================================================================================================================
+//     CLASS: JobSystem
+// ====================================================================================================================
+
+JobSystem::JobGroup::JobGroup()
+    : m_pending{ 0 },
+      m_exception{ nullptr }
+{
+}
+
+JobSystem::JobGroup::~JobGroup()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<JobSystem> JobSystem::create(std::size_t worker_count_)
+{
+    struct MakeSharedEnabler : public JobSystem
+    {
+        MakeSharedEnabler(std::size_t worker_count_)
+            : JobSystem(worker_count_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(worker_count_);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+JobSystem::JobSystem(std::size_t worker_count_)
+    : m_queued_count{ 0 },
+      m_sleeping_workers{ 0 },
+      m_sleeping_waiters{ 0 },
+      m_is_stopping{ false },
+      m_statistics_start{ Clock::now().time_since_epoch().count() }
+{
+    for (std::size_t i = 0; i < worker_count_ + 1; i++)
+    {
+        m_queues.push_back(std::make_unique<Queue>());
+        m_counters.push_back(std::make_unique<Counters>());
+    }
+
+    m_workers.reserve(worker_count_);
+    for (std::size_t i = 0; i < worker_count_; i++)
+        m_workers.emplace_back(&JobSystem::p_worker_main, this, i);
+}
+
+//
+// Every group and job has to be waited for before, jobs still queued are dropped.
+//
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_is_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::run(JobGroup& group_, std::function<void()> function_)
+{
+    group_.m_pending.fetch_add(1, std::memory_order_relaxed);
+    p_push(Task{ .function = std::move(function_), .group = &group_, .job = nullptr });
+}
+
+//
+// Runs queued jobs until every job of the group finished.
+//
+void JobSystem::wait(JobGroup& group_)
+{
+    MAPLE_TRACE_SCOPE("JobSystem::wait", "job_system");
+
+    p_wait_until([&group_]() { return group_.m_pending.load() == 0; });
+
+    if (group_.m_exception)
+        std::rethrow_exception(std::exchange(group_.m_exception, nullptr));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Queues the function once every dependency finished, right away when there are none.
+//
+JobSystem::JobHandle JobSystem::submit(std::function<void()> function_, std::span<const JobHandle> dependencies_)
+{
+    auto job = std::make_shared<Job>();
+    job->m_function = std::move(function_);
+
+    for (auto& dependency : dependencies_)
+    {
+        std::lock_guard<std::mutex> lock(dependency->m_mutex);
+        if (dependency->m_is_done.load(std::memory_order_relaxed))
+            continue;
+        job->m_unfinished_dependencies.fetch_add(1, std::memory_order_relaxed);
+        dependency->m_dependents.push_back(job);
+    }
+
+    if (job->m_unfinished_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        p_push(Task{ .function = nullptr, .group = nullptr, .job = job });
+    return job;
+}
+
+//
+// Runs queued jobs until the job finished, and rethrows what it threw.
+//
+void JobSystem::wait(const JobHandle& job_)
+{
+    MAPLE_TRACE_SCOPE("JobSystem::wait", "job_system");
+
+    p_wait_until([&job_]() { return job_->m_is_done.load(); });
+
+    if (job_->m_exception)
+        std::rethrow_exception(job_->m_exception);
+}
+
+bool JobSystem::is_done(const JobHandle& job_) const
+{
+    return job_->m_is_done.load(std::memory_order_acquire);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::size_t JobSystem::get_worker_count() const
+{
+    return m_workers.size();
+}
+
+//
+// One entry per worker, then one for the threads outside the system.
+//
+std::vector<JobSystem::WorkerStatistics> JobSystem::get_worker_statistics() const
+{
+    Clock::duration elapsed = Clock::now().time_since_epoch() - Clock::duration(m_statistics_start.load());
+    double elapsed_nanoseconds = static_cast<double>(std::chrono::nanoseconds(elapsed).count());
+
+    std::vector<WorkerStatistics> statistics;
+    statistics.reserve(m_counters.size());
+    for (auto& counters : m_counters)
+    {
+        std::int64_t busy = counters->busy_nanoseconds.load(std::memory_order_relaxed);
+        statistics.push_back(WorkerStatistics{
+            .executed_jobs = counters->executed_jobs.load(std::memory_order_relaxed),
+            .stolen_jobs = counters->stolen_jobs.load(std::memory_order_relaxed),
+            .busy_time = std::chrono::nanoseconds(busy),
+            .utilization = elapsed_nanoseconds > 0.0 ? static_cast<double>(busy) / elapsed_nanoseconds : 0.0 });
+    }
+    return statistics;
+}
+
+void JobSystem::reset_worker_statistics()
+{
+    for (auto& counters : m_counters)
+    {
+        counters->executed_jobs.store(0, std::memory_order_relaxed);
+        counters->stolen_jobs.store(0, std::memory_order_relaxed);
+        counters->busy_nanoseconds.store(0, std::memory_order_relaxed);
+    }
+    m_statistics_start.store(Clock::now().time_since_epoch().count());
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::size_t JobSystem::p_get_queue_index() const
+{
+    return current_system == this ? current_index : m_workers.size();
+}
+
+void JobSystem::p_push(Task task_)
+{
+    {
+        auto& queue = *m_queues[p_get_queue_index()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task_));
+    }
+    // sequentially consistent, like a thread going to sleep counting itself before it checks the count:
+    // either it sees the job, or this sees it sleeping, so a push only locks when someone may need waking
+    m_queued_count.fetch_add(1);
+    bool has_sleeping_workers = m_sleeping_workers.load() > 0;
+    bool has_sleeping_waiters = m_sleeping_waiters.load() > 0;
+    if (!has_sleeping_workers && !has_sleeping_waiters)
+        return;
+
+    // a thread that counted itself but did not start waiting yet still holds the lock
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    }
+    if (has_sleeping_workers)
+        m_wake.notify_one();
+    if (has_sleeping_waiters)
+        m_waiter_wake.notify_all();
+}
+
+//
+// Takes the newest job of the own deque, or steals the oldest job of the next deque that has one.
+//
+bool JobSystem::p_take(std::size_t index_, Task& task_)
+{
+    {
+        auto& queue = *m_queues[index_];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task_ = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            m_queued_count.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < m_queues.size(); i++)
+    {
+        auto& queue = *m_queues[(index_ + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task_ = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_queued_count.fetch_sub(1);
+            m_counters[index_]->stolen_jobs.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Runs queued jobs until is_done_ returns true. A thread that keeps finding nothing to take
+// sleeps until a job is queued, or until a group or a job finished. is_done_ has to load sequentially consistently.
+//
+template <typename Predicate>
+void JobSystem::p_wait_until(Predicate is_done_)
+{
+    std::size_t index = p_get_queue_index();
+    std::size_t failed_takes = 0;
+    while (!is_done_())
+    {
+        Task task;
+        if (p_take(index, task))
+        {
+            p_execute(index, task);
+            failed_takes = 0;
+            continue;
+        }
+
+        if (++failed_takes < failed_takes_before_sleep)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleeping_waiters.fetch_add(1);
+        m_waiter_wake.wait(lock, [&]() { return is_done_() || m_queued_count.load() > 0; });
+        m_sleeping_waiters.fetch_sub(1);
+    }
+}
+
+void JobSystem::p_execute(std::size_t index_, Task& task_)
+{
+    bool is_outermost = execute_depth++ == 0;
+    auto start = Clock::now();
+    if (task_.job)
+        p_finish(task_.job);
+    else
+    {
+        try
+        {
+            task_.function();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(task_.group->m_exception_mutex);
+            if (!task_.group->m_exception)
+                task_.group->m_exception = std::current_exception();
+        }
+
+        // the waiting thread may destroy the group as soon as the count drops
+        if (task_.group->m_pending.fetch_sub(1) == 1)
+            p_notify_waiters();
+    }
+
+    execute_depth--;
+    auto& counters = *m_counters[index_];
+    counters.executed_jobs.fetch_add(1, std::memory_order_relaxed);
+    if (is_outermost)
+        counters.busy_nanoseconds.fetch_add(std::chrono::nanoseconds(Clock::now() - start).count(),
+                                            std::memory_order_relaxed);
+}
+
+//
+// Runs a submitted job, then queues every dependent whose last dependency it was.
+//
+void JobSystem::p_finish(const JobHandle& job_)
+{
+    try
+    {
+        job_->m_function();
+    }
+    catch (...)
+    {
+        job_->m_exception = std::current_exception();
+    }
+    job_->m_function = nullptr;
+
+    std::vector<JobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job_->m_mutex);
+        job_->m_is_done.store(true);
+        dependents.swap(job_->m_dependents);
+    }
+
+    p_notify_waiters();
+
+    for (auto& dependent : dependents)
+        if (dependent->m_unfinished_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            p_push(Task{ .function = nullptr, .group = nullptr, .job = dependent });
+}
+
+//
+// Wakes the threads sleeping in wait after a group or a job finished, so they check whether it was theirs.
+// Finishing and the check in wait are sequentially consistent, so a waiter that did not see its group or job
+// finished before it slept is counted here.
+//
+void JobSystem::p_notify_waiters()
+{
+    if (m_sleeping_waiters.load() == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    }
+    m_waiter_wake.notify_all();
+}
+
+void JobSystem::p_worker_main(std::size_t index_)
+{
+    current_system = this;
+    current_index = index_;
+    MAPLE_INSTRUMENT(Tracer::set_thread_name("worker " + std::to_string(index_));)
+
+    while (true)
+    {
+        Task task;
+        if (p_take(index_, task))
+        {
+            p_execute(index_, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleeping_workers.fetch_add(1);
+        m_wake.wait(lock, [this]() { return m_is_stopping || m_queued_count.load() > 0; });
+        m_sleeping_workers.fetch_sub(1);
+        if (m_is_stopping)
+            return;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,69 @@
+#include "opengl_util/fence_tracker.h"
+
+#include <glad/gl.h>
+
+namespace maple
+{
+namespace gl
+{
+
+std::shared_ptr<FenceTracker> FenceTracker::create()
+{
+    struct MakeSharedEnabler : public FenceTracker {};
+    return std::make_shared<MakeSharedEnabler>();
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+FenceTracker::FenceTracker()
+{
+}
+
+FenceTracker::~FenceTracker()
+{
+    for (auto& fence : m_fences)
+        glDeleteSync(static_cast<GLsync>(fence.sync));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Flushes, so the fence reaches the GPU even if nothing else is submitted before the next collect.
+//
+void FenceTracker::insert(std::uint64_t id_)
+{
+    m_fences.push_back(Fence{ .id = id_, .sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    glFlush();
+}
+
+//
+// Appends every fence that signaled by now, in the order they were inserted, and never blocks.
+//
+std::size_t FenceTracker::collect(std::vector<Result>& results_)
+{
+    auto now = Clock::now();
+
+    std::size_t count = 0;
+    for (; count < m_fences.size(); count++)
+    {
+        GLsync sync = static_cast<GLsync>(m_fences[count].sync);
+        if (glClientWaitSync(sync, 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+
+        glDeleteSync(sync);
+        results_.push_back(Result{ .id = m_fences[count].id, .time = now });
+    }
+
+    m_fences.erase(m_fences.begin(), m_fences.begin() + count);
+    return count;
+}
+
+bool FenceTracker::is_pending() const
+{
+    return !m_fences.empty();
+}
+
+}
+}
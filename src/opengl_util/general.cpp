@@ -1,4 +1,7 @@
 #include "opengl_util/general.h"
+#include "opengl_util/state_tracker.h"
+#include "opengl_util/program_cache.h"
+#include "tracing.h"
 
 #include <glad/gl.h>
 
@@ -7,25 +10,137 @@ namespace maple
 namespace gl
 {
 
+namespace
+{
+
+//
+// GL_COMPLETION_STATUS_KHR of GL_KHR_parallel_shader_compile and GL_ARB_parallel_shader_compile.
+// Not part of the core profile loaded by glad.
+//
+constexpr GLenum completion_status = 0x91B1;
+
+unsigned int start_compile(GLenum type_, const std::string& source_)
+{
+    unsigned int shader = glCreateShader(type_);
+    const char* shader_source = source_.c_str();
+    glShaderSource(shader, 1, &shader_source, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+//
+// Issues compilation of both stages and the link, without querying any status,
+// so that the driver is free to finish the work in the background.
+//
+void start_build(unsigned int program_, const std::string& vertex_, const std::string& fragment_,
+                 unsigned int& vertex_shader_, unsigned int& fragment_shader_)
+{
+    vertex_shader_ = start_compile(GL_VERTEX_SHADER, vertex_);
+    fragment_shader_ = start_compile(GL_FRAGMENT_SHADER, fragment_);
+
+    glAttachShader(program_, vertex_shader_);
+    glAttachShader(program_, fragment_shader_);
+    glLinkProgram(program_);
+}
+
+//
+// Waits for the build started by start_build, prints the logs of failed stages and releases the shader objects.
+// Returns the link status.
+//
+bool finish_build(unsigned int program_, unsigned int vertex_shader_, unsigned int fragment_shader_)
+{
+    int success;
+    char message[512];
+    glGetShaderiv(vertex_shader_, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertex_shader_, 512, nullptr, message);
+        out(message);
+    }
+
+    glGetShaderiv(fragment_shader_, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragment_shader_, 512, nullptr, message);
+        out(message);
+    }
+
+    glGetProgramiv(program_, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program_, 512, nullptr, message);
+        out(message);
+    }
+
+    glDetachShader(program_, vertex_shader_);
+    glDetachShader(program_, fragment_shader_);
+    glDeleteShader(vertex_shader_);
+    glDeleteShader(fragment_shader_);
+
+    return success;
+}
+
+}
+
 std::shared_ptr<VertexBuffer> VertexBuffer::create()
 {
     struct MakeSharedEnabler : public VertexBuffer {};
     return std::make_shared<MakeSharedEnabler>();
 }
 
+std::shared_ptr<StreamBuffer> StreamBuffer::create(std::size_t region_size_, unsigned int region_count_)
+{
+    struct MakeSharedEnabler : public StreamBuffer {
+        MakeSharedEnabler(std::size_t region_size_, unsigned int region_count_)
+            : StreamBuffer(region_size_, region_count_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(region_size_, region_count_);
+}
+
 std::shared_ptr<VertexArray> VertexArray::create()
 {
     struct MakeSharedEnabler : public VertexArray {};
     return std::make_shared<MakeSharedEnabler>();
 }
 
-std::shared_ptr<Shader> Shader::create(const std::string& vertex_, const std::string& fragment_)
+std::shared_ptr<Framebuffer> Framebuffer::create(const Size& size_)
+{
+    struct MakeSharedEnabler : public Framebuffer {
+        MakeSharedEnabler(const Size& size_)
+            : Framebuffer(size_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(size_);
+}
+
+std::shared_ptr<Shader> Shader::create(const std::string& vertex_, const std::string& fragment_,
+                                       const std::shared_ptr<ProgramBinaryCache>& cache_)
+{
+    struct MakeSharedEnabler : public Shader {
+        MakeSharedEnabler(const std::string& vertex_, const std::string& fragment_,
+                          const std::shared_ptr<ProgramBinaryCache>& cache_)
+            : Shader(vertex_, fragment_, cache_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(vertex_, fragment_, cache_);
+}
+
+std::shared_ptr<Shader> Shader::p_create(unsigned int program_)
 {
     struct MakeSharedEnabler : public Shader {
-        MakeSharedEnabler(const std::string& vertex_, const std::string& fragment_)
-            : Shader(vertex_, fragment_) {}
+        MakeSharedEnabler(unsigned int program_)
+            : Shader(program_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(program_);
+}
+
+std::shared_ptr<ShaderFuture> ShaderFuture::create(const std::string& vertex_, const std::string& fragment_,
+                                                   const std::shared_ptr<ProgramBinaryCache>& cache_)
+{
+    struct MakeSharedEnabler : public ShaderFuture {
+        MakeSharedEnabler(const std::string& vertex_, const std::string& fragment_,
+                          const std::shared_ptr<ProgramBinaryCache>& cache_)
+            : ShaderFuture(vertex_, fragment_, cache_) {}
     };
-    return std::make_shared<MakeSharedEnabler>(vertex_, fragment_);
+    return std::make_shared<MakeSharedEnabler>(vertex_, fragment_, cache_);
 }
 
 // ====================================================================================================================
@@ -35,24 +150,23 @@ std::shared_ptr<Shader> Shader::create(const std::string& vertex_, const std::st
 VertexBuffer::VertexBuffer()
     : m_id{ 0 }
 {
-    glGenBuffers(1, &m_id);
-    bind();
+    glCreateBuffers(1, &m_id);
 }
 
 VertexBuffer::~VertexBuffer()
 {
-    unbind();
+    StateTracker::forget_buffer(m_id);
     glDeleteBuffers(1, &m_id);
 }
 
 void VertexBuffer::bind()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    StateTracker::get_current().bind_buffer(GL_ARRAY_BUFFER, m_id);
 }
 
 void VertexBuffer::unbind()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    StateTracker::get_current().bind_buffer(GL_ARRAY_BUFFER, 0);
 }
 
 unsigned int VertexBuffer::get_id()
@@ -60,27 +174,174 @@ unsigned int VertexBuffer::get_id()
     return m_id;
 }
 
+StreamBuffer::StreamBuffer(std::size_t region_size_, unsigned int region_count_)
+    : m_id{ 0 },
+      m_mapped{ nullptr },
+      m_region_size{ region_size_ },
+      m_regions(std::max(region_count_, 2u)),
+      m_current_region{ 0 },
+      m_region_offset{ 0 }
+{
+    p_create_storage();
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    p_destroy_storage();
+}
+
+void StreamBuffer::bind()
+{
+    StateTracker::get_current().bind_buffer(GL_ARRAY_BUFFER, m_id);
+}
+
+void StreamBuffer::unbind()
+{
+    StateTracker::get_current().bind_buffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int StreamBuffer::get_id()
+{
+    return m_id;
+}
+
+//
+// Returns a write pointer into the mapped storage and its byte offset from the start of the buffer.
+// Moving on to the next region waits until the GPU is done with it, which only stalls
+// when more frames are in flight than there are regions.
+// A request larger than a region recreates the storage, so the buffer id may change.
+//
+StreamBuffer::Allocation StreamBuffer::allocate(std::size_t size_, std::size_t alignment_)
+{
+    if (size_ > m_region_size)
+    {
+        while (m_region_size < size_)
+            m_region_size *= 2;
+
+        p_destroy_storage();
+        p_create_storage();
+        m_statistics.reallocations++;
+    }
+
+    std::size_t offset = (m_region_offset + alignment_ - 1) / alignment_ * alignment_;
+    if (offset + size_ > m_region_size)
+    {
+        m_current_region = (m_current_region + 1) % m_regions.size();
+        p_wait(m_regions[m_current_region]);
+        offset = 0;
+    }
+
+    m_region_offset = offset + size_;
+    m_regions[m_current_region].is_written = true;
+    m_statistics.allocations++;
+
+    std::size_t buffer_offset = m_current_region * m_region_size + offset;
+    return Allocation{ .data = m_mapped + buffer_offset, .offset = buffer_offset };
+}
+
+//
+// Call after the draws that read the allocated data have been issued, in the same OpenGL context.
+// The fences are flushed right away. GL_SYNC_FLUSH_COMMANDS_BIT in p_wait only flushes the context
+// that waits, so a fence left unflushed in another context sharing the buffer would never signal.
+//
+void StreamBuffer::fence()
+{
+    bool is_fenced = false;
+    for (auto& region : m_regions)
+    {
+        if (!region.is_written)
+            continue;
+
+        region.fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        region.is_written = false;
+        is_fenced = true;
+    }
+
+    if (is_fenced)
+        glFlush();
+}
+
+std::size_t StreamBuffer::get_region_size() const
+{
+    return m_region_size;
+}
+
+const StreamBuffer::Statistics& StreamBuffer::get_statistics() const
+{
+    return m_statistics;
+}
+
+void StreamBuffer::p_create_storage()
+{
+    MAPLE_TRACE_SCOPE("StreamBuffer::p_create_storage", "upload");
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    std::size_t size = m_region_size * m_regions.size();
+
+    glCreateBuffers(1, &m_id);
+    glNamedBufferStorage(m_id, size, nullptr, flags);
+    m_mapped = static_cast<std::byte*>(glMapNamedBufferRange(m_id, 0, size, flags));
+    if (!m_mapped)
+        throw std::runtime_error("void StreamBuffer::p_create_storage(): "
+                                 "Failed to map buffer storage. glMapNamedBufferRange()");
+
+    m_current_region = 0;
+    m_region_offset = 0;
+}
+
+void StreamBuffer::p_destroy_storage()
+{
+    for (auto& region : m_regions)
+    {
+        for (void* fence : region.fences)
+            glDeleteSync(static_cast<GLsync>(fence));
+        region.fences.clear();
+        region.is_written = false;
+    }
+
+    glUnmapNamedBuffer(m_id);
+    StateTracker::forget_buffer(m_id);
+    glDeleteBuffers(1, &m_id);
+    m_mapped = nullptr;
+}
+
+void StreamBuffer::p_wait(Region& region_)
+{
+    for (void* fence : region_.fences)
+    {
+        GLsync sync = static_cast<GLsync>(fence);
+        GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            m_statistics.stalls++;
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(sync, 0, 1'000'000);
+        }
+        glDeleteSync(sync);
+    }
+    region_.fences.clear();
+}
+
 VertexArray::VertexArray()
     : m_id{ 0 }
 {
-    glGenVertexArrays(1, &m_id);
-    bind();
+    glCreateVertexArrays(1, &m_id);
 }
 
 VertexArray::~VertexArray()
 {
-    unbind();
+    StateTracker::forget_vertex_array(m_id);
     glDeleteVertexArrays(1, &m_id);
 }
 
 void VertexArray::bind()
 {
-    glBindVertexArray(m_id);
+    StateTracker::get_current().bind_vertex_array(m_id);
 }
 
 void VertexArray::unbind()
 {
-    glBindVertexArray(0);
+    StateTracker::get_current().bind_vertex_array(0);
 }
 
 unsigned int VertexArray::get_id()
@@ -89,74 +350,243 @@ unsigned int VertexArray::get_id()
 }
 
 
-// ====================================================================================================================
-// ====================================================================================================================
+Framebuffer::Framebuffer(const Size& size_)
+    : m_id{ 0 },
+      m_color_texture{ 0 },
+      m_size{ size_ }
+{
+    glCreateFramebuffers(1, &m_id);
+    p_create_attachments();
+}
 
-Shader::Shader(const std::string& vertex_, const std::string& fragment_)
+Framebuffer::~Framebuffer()
 {
-    unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    const char* vertex_shader_source = vertex_.c_str();
-    glShaderSource(vertex_shader, 1, &vertex_shader_source, nullptr);
-    glCompileShader(vertex_shader);
+    StateTracker::forget_framebuffer(m_id);
+    glDeleteFramebuffers(1, &m_id);
+    glDeleteTextures(1, &m_color_texture);
+}
 
-    int success;
-    char message[512];
-    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertex_shader, 512, nullptr, message);
-        out(message);
-    }
+void Framebuffer::bind()
+{
+    StateTracker::get_current().bind_framebuffer(GL_FRAMEBUFFER, m_id);
+}
 
-    unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* fragment_shader_source = fragment_.c_str();
-    glShaderSource(fragment_shader, 1, &fragment_shader_source, nullptr);
-    glCompileShader(fragment_shader);
+void Framebuffer::unbind()
+{
+    StateTracker::get_current().bind_framebuffer(GL_FRAMEBUFFER, 0);
+}
 
-    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragment_shader, 512, nullptr, message);
-        out(message);
-    }
+unsigned int Framebuffer::get_id()
+{
+    return m_id;
+}
+
+unsigned int Framebuffer::get_color_texture()
+{
+    return m_color_texture;
+}
 
-    m_id = glCreateProgram();
-    glAttachShader(m_id, vertex_shader);
-    glAttachShader(m_id, fragment_shader);
-    glLinkProgram(m_id);
+Size Framebuffer::get_size() const
+{
+    return m_size;
+}
 
-    glGetProgramiv(m_id, GL_LINK_STATUS, &success);
-    if (!success)
+//
+// The color texture uses immutable storage, so resizing replaces it.
+//
+void Framebuffer::resize(const Size& size_)
+{
+    if (size_.width == m_size.width && size_.height == m_size.height)
+        return;
+
+    m_size = size_;
+    glDeleteTextures(1, &m_color_texture);
+    p_create_attachments();
+}
+
+void Framebuffer::p_create_attachments()
+{
+    MAPLE_TRACE_SCOPE("Framebuffer::p_create_attachments", "upload");
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_color_texture);
+    glTextureStorage2D(m_color_texture, 1, GL_RGBA8, std::max(m_size.width, 1), std::max(m_size.height, 1));
+    glTextureParameteri(m_color_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(m_color_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glNamedFramebufferTexture(m_id, GL_COLOR_ATTACHMENT0, m_color_texture, 0);
+
+    if (glCheckNamedFramebufferStatus(m_id, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("void Framebuffer::p_create_attachments(): "
+                                 "Framebuffer is incomplete. glCheckNamedFramebufferStatus()");
+}
+
+
+// ====================================================================================================================
+// ====================================================================================================================
+
+Shader::Shader(const std::string& vertex_, const std::string& fragment_,
+               const std::shared_ptr<ProgramBinaryCache>& cache_)
+    : m_id{ glCreateProgram() }
+{
+    MAPLE_TRACE_SCOPE("Shader::Shader", "shader");
+
+    std::string key;
+    if (cache_ && cache_->is_enabled())
     {
-        glGetProgramInfoLog(m_id, 512, nullptr, message);
-        out(message);
+        key = cache_->make_key(vertex_, fragment_);
+        if (cache_->load(m_id, key))
+        {
+            p_reflect_uniforms();
+            return;
+        }
+
+        glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     }
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+    unsigned int vertex_shader = 0;
+    unsigned int fragment_shader = 0;
+    start_build(m_id, vertex_, fragment_, vertex_shader, fragment_shader);
+    if (finish_build(m_id, vertex_shader, fragment_shader) && !key.empty())
+        cache_->store(m_id, key);
+
+    p_reflect_uniforms();
+}
 
-    bind();
+//
+// Takes ownership of an already linked program.
+//
+Shader::Shader(unsigned int program_)
+    : m_id{ program_ }
+{
+    p_reflect_uniforms();
 }
 
 Shader::~Shader()
 {
-    unbind();
+    StateTracker::forget_program(m_id);
     glDeleteProgram(m_id);
 }
 
 void Shader::bind()
 {
-    glUseProgram(m_id);
+    StateTracker::get_current().use_program(m_id);
 }
 
 void Shader::unbind()
 {
-    glUseProgram(0);
+    StateTracker::get_current().use_program(0);
+}
+
+UniformHandle Shader::get_uniform(std::string_view name_) const
+{
+    auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), name_,
+                               [](const Uniform& uniform_, std::string_view name_)
+                               {
+                                   return uniform_.name < name_;
+                               });
+    if (it == m_uniforms.end() || it->name != name_)
+        return UniformHandle{};
+
+    return UniformHandle{ .location = it->location };
+}
+
+const std::vector<Shader::Uniform>& Shader::get_uniforms() const
+{
+    return m_uniforms;
+}
+
+void Shader::set_uniform_int(UniformHandle handle_, int value_)
+{
+    glProgramUniform1i(m_id, handle_.location, value_);
+}
+
+void Shader::set_uniform_vec2(UniformHandle handle_, float x_, float y_)
+{
+    glProgramUniform2f(m_id, handle_.location, x_, y_);
+}
+
+void Shader::set_uniform_vec4(UniformHandle handle_, float x_, float y_, float z_, float w_)
+{
+    glProgramUniform4f(m_id, handle_.location, x_, y_, z_, w_);
+}
+
+void Shader::set_uniform_mat3(UniformHandle handle_, const float* column_major_)
+{
+    glProgramUniformMatrix3fv(m_id, handle_.location, 1, GL_FALSE, column_major_);
+}
+
+void Shader::set_uniform_int_array(UniformHandle handle_, const int* values_, int count_)
+{
+    glProgramUniform1iv(m_id, handle_.location, count_, values_);
+}
+
+void Shader::set_uniform_vec2_array(UniformHandle handle_, const float* values_, int count_)
+{
+    glProgramUniform2fv(m_id, handle_.location, count_, values_);
+}
+
+void Shader::set_uniform_vec4_array(UniformHandle handle_, const float* values_, int count_)
+{
+    glProgramUniform4fv(m_id, handle_.location, count_, values_);
+}
+
+void Shader::set_uniform_mat3_array(UniformHandle handle_, const float* column_major_, int count_)
+{
+    glProgramUniformMatrix3fv(m_id, handle_.location, count_, GL_FALSE, column_major_);
+}
+
+//
+// Convenience setters for code that is not on a per-frame path. Looked up in the reflected table.
+//
+void Shader::set_uniform_vec2(const std::string& name_, float x_, float y_)
+{
+    set_uniform_vec2(get_uniform(name_), x_, y_);
 }
 
 void Shader::set_uniform_vec4(const std::string& name_, float r_, float g_, float b_, float a_)
 {
-    glUniform4f(glGetUniformLocation(m_id, name_.c_str()), r_, g_, b_, a_);
+    set_uniform_vec4(get_uniform(name_), r_, g_, b_, a_);
+}
+
+//
+// Uniforms inside uniform blocks have no location and are skipped.
+// Arrays are reported as "name[0]" and stored as "name", pointing at the first element.
+//
+void Shader::p_reflect_uniforms()
+{
+    int count = 0;
+    int max_length = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    m_uniforms.clear();
+    m_uniforms.reserve(count);
+
+    std::string name(std::max(max_length, 1), '\0');
+    for (int i = 0; i < count; i++)
+    {
+        int length = 0;
+        int array_size = 0;
+        unsigned int type = 0;
+        glGetActiveUniform(m_id, i, max_length, &length, &array_size, &type, name.data());
+
+        Uniform uniform{ .name       = name.substr(0, length),
+                         .location   = glGetUniformLocation(m_id, name.c_str()),
+                         .type       = type,
+                         .array_size = array_size };
+        if (uniform.location < 0)
+            continue;
+
+        if (uniform.name.ends_with("[0]"))
+            uniform.name.resize(uniform.name.size() - 3);
+
+        m_uniforms.push_back(std::move(uniform));
+    }
+
+    std::sort(m_uniforms.begin(), m_uniforms.end(),
+              [](const Uniform& a_, const Uniform& b_)
+              {
+                  return a_.name < b_.name;
+              });
 }
 
 unsigned int Shader::get_id()
@@ -164,5 +594,86 @@ unsigned int Shader::get_id()
     return m_id;
 }
 
+// ====================================================================================================================
+// ====================================================================================================================
+
+ShaderFuture::ShaderFuture(const std::string& vertex_, const std::string& fragment_,
+                           const std::shared_ptr<ProgramBinaryCache>& cache_)
+    : m_program{ glCreateProgram() },
+      m_vertex_shader{ 0 },
+      m_fragment_shader{ 0 },
+      m_cache{ cache_ }
+{
+    MAPLE_TRACE_SCOPE("ShaderFuture::ShaderFuture", "shader");
+
+    if (m_cache && m_cache->is_enabled())
+    {
+        m_key = m_cache->make_key(vertex_, fragment_);
+        if (m_cache->load(m_program, m_key))
+        {
+            m_shader = Shader::p_create(m_program);
+            return;
+        }
+
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    start_build(m_program, vertex_, fragment_, m_vertex_shader, m_fragment_shader);
+}
+
+ShaderFuture::~ShaderFuture()
+{
+    if (m_shader)
+        return;
+
+    glDeleteShader(m_vertex_shader);
+    glDeleteShader(m_fragment_shader);
+    glDeleteProgram(m_program);
+}
+
+//
+// Checked once per process, since the extension list requires a current OpenGL context.
+//
+bool ShaderFuture::is_parallel_compile_supported()
+{
+    static const bool is_supported = []
+        {
+            int count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (int i = 0; i < count; i++)
+            {
+                std::string_view name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (name == "GL_KHR_parallel_shader_compile" || name == "GL_ARB_parallel_shader_compile")
+                    return true;
+            }
+            return false;
+        }();
+
+    return is_supported;
+}
+
+bool ShaderFuture::is_ready()
+{
+    if (m_shader || !is_parallel_compile_supported())
+        return true;
+
+    int is_complete = 0;
+    glGetProgramiv(m_program, completion_status, &is_complete);
+    return is_complete;
+}
+
+std::shared_ptr<Shader> ShaderFuture::get()
+{
+    if (m_shader)
+        return m_shader;
+
+    MAPLE_TRACE_SCOPE("ShaderFuture::get", "shader");
+    if (finish_build(m_program, m_vertex_shader, m_fragment_shader) && !m_key.empty())
+        m_cache->store(m_program, m_key);
+
+    m_shader = Shader::p_create(m_program);
+    return m_shader;
+}
+
 }
 }
\ No newline at end of file
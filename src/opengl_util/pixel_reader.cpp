@@ -0,0 +1,140 @@
+#include "opengl_util/pixel_reader.h"
+#include "opengl_util/state_tracker.h"
+#include "tracing.h"
+
+#include <glad/gl.h>
+
+#include <cstring>
+
+namespace maple
+{
+namespace gl
+{
+
+std::shared_ptr<PixelReader> PixelReader::create()
+{
+    struct MakeSharedEnabler : public PixelReader {};
+    return std::make_shared<MakeSharedEnabler>();
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+PixelReader::PixelReader()
+{
+}
+
+PixelReader::~PixelReader()
+{
+    for (auto& request : m_requests)
+    {
+        glDeleteSync(static_cast<GLsync>(request.fence));
+        m_free_buffers.push_back(request.buffer);
+    }
+
+    for (auto& buffer : m_free_buffers)
+    {
+        StateTracker::forget_buffer(buffer.id);
+        glDeleteBuffers(1, &buffer.id);
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Queues a copy of the first color attachment of the framebuffer, or of the back buffer for framebuffer 0.
+// Must be called after the frame was drawn and before it is swapped.
+//
+void PixelReader::read(unsigned int framebuffer_, const Size& size_)
+{
+    MAPLE_TRACE_SCOPE("PixelReader::read", "upload");
+
+    std::size_t size = static_cast<std::size_t>(size_.width) * size_.height * 4;
+
+    Buffer buffer;
+    if (!m_free_buffers.empty())
+    {
+        buffer = m_free_buffers.back();
+        m_free_buffers.pop_back();
+    }
+    else
+    {
+        glCreateBuffers(1, &buffer.id);
+        m_statistics.buffers++;
+    }
+
+    if (buffer.capacity < size)
+    {
+        glNamedBufferData(buffer.id, size, nullptr, GL_STREAM_READ);
+        buffer.capacity = size;
+    }
+
+    auto& tracker = StateTracker::get_current();
+    tracker.bind_framebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+    if (framebuffer_ == 0)
+        glReadBuffer(GL_BACK);
+
+    // a bound pack buffer turns the pointer of glReadPixels into an offset into the buffer
+    tracker.bind_buffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, size_.width, size_.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    tracker.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_requests.push_back(Request{ .buffer = buffer,
+                                  .size   = size_,
+                                  .fence  = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    m_statistics.reads++;
+}
+
+//
+// Appends the images of every completed read, in the order they were read, and never blocks.
+//
+std::size_t PixelReader::collect(std::vector<Image>& images_)
+{
+    std::size_t count = 0;
+    while (!m_requests.empty())
+    {
+        Request& request = m_requests.front();
+        GLenum status = glClientWaitSync(static_cast<GLsync>(request.fence), 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            break;
+        glDeleteSync(static_cast<GLsync>(request.fence));
+
+        MAPLE_TRACE_SCOPE("PixelReader::collect", "upload");
+
+        std::size_t row_size = static_cast<std::size_t>(request.size.width) * 4;
+        Image image{ .size = request.size, .pixels = std::vector<std::uint8_t>(row_size * request.size.height) };
+
+        auto* mapped = static_cast<const std::uint8_t*>(
+            glMapNamedBufferRange(request.buffer.id, 0, image.pixels.size(), GL_MAP_READ_BIT));
+        if (mapped)
+        {
+            // OpenGL stores the bottom row first
+            for (int y = 0; y < request.size.height; y++)
+                std::memcpy(image.pixels.data() + y * row_size,
+                            mapped + (request.size.height - 1 - y) * row_size,
+                            row_size);
+            glUnmapNamedBuffer(request.buffer.id);
+        }
+
+        images_.push_back(std::move(image));
+        m_free_buffers.push_back(request.buffer);
+        m_requests.erase(m_requests.begin());
+        count++;
+    }
+    return count;
+}
+
+bool PixelReader::is_pending() const
+{
+    return !m_requests.empty();
+}
+
+const PixelReader::Statistics& PixelReader::get_statistics() const
+{
+    return m_statistics;
+}
+
+}
+}
@@ -0,0 +1,227 @@
+#include "opengl_util/program_cache.h"
+
+#include <glad/gl.h>
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace maple
+{
+namespace gl
+{
+
+namespace
+{
+
+//
+// Header written in front of every cached binary.
+//
+struct BinaryHeader
+{
+    std::uint32_t magic{ 0x424C504D };   // "MPLB"
+    std::uint32_t format{ 0 };
+    std::uint32_t length{ 0 };
+};
+
+//
+// FNV-1a, used instead of std::hash since the key has to be stable across runs and standard libraries.
+//
+std::uint64_t hash(std::string_view data_, std::uint64_t seed_ = 0xcbf29ce484222325ull)
+{
+    std::uint64_t value = seed_;
+    for (char c : data_)
+    {
+        value ^= static_cast<unsigned char>(c);
+        value *= 0x100000001b3ull;
+    }
+    return value;
+}
+
+//
+// Unique per process and per call, so concurrent writers of the same key never share a temporary file.
+//
+std::string make_temporary_suffix()
+{
+    static std::atomic<std::uint64_t> counter{ 0 };
+#ifdef _WIN32
+    long long process = _getpid();
+#else
+    long long process = getpid();
+#endif
+    return "." + std::to_string(process) + "." + std::to_string(counter++) + ".tmp";
+}
+
+}
+
+std::shared_ptr<ProgramBinaryCache> ProgramBinaryCache::create(const std::filesystem::path& directory_)
+{
+    struct MakeSharedEnabler : public ProgramBinaryCache {
+        MakeSharedEnabler(const std::filesystem::path& directory_)
+            : ProgramBinaryCache(directory_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(directory_);
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+ProgramBinaryCache::ProgramBinaryCache(const std::filesystem::path& directory_)
+    : m_directory{ directory_ },
+      m_is_enabled{ false }
+{
+    int format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (format_count <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+    {
+        out("ProgramBinaryCache: Failed to create cache directory " << m_directory << ". " << error.message());
+        return;
+    }
+
+    m_driver = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    m_driver += '\n';
+    m_driver += reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    m_is_enabled = true;
+}
+
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+bool ProgramBinaryCache::is_enabled() const
+{
+    return m_is_enabled;
+}
+
+std::string ProgramBinaryCache::make_key(const std::string& vertex_, const std::string& fragment_) const
+{
+    std::uint64_t value = hash(m_driver);
+    value = hash(vertex_, value);
+    value = hash(std::string_view("\0", 1), value);
+    value = hash(fragment_, value);
+
+    char key[17];
+    std::snprintf(key, sizeof key, "%016llx", static_cast<unsigned long long>(value));
+    return key;
+}
+
+//
+// Returns false on a miss or when the driver rejects the binary, for example after a driver update
+// that kept the version string. The program is then left unlinked and can be built from source.
+//
+bool ProgramBinaryCache::load(unsigned int program_, const std::string& key_)
+{
+    if (!m_is_enabled)
+        return false;
+
+    auto path = p_get_path(key_);
+    std::ifstream file(path, std::ios::binary);
+    BinaryHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof header) || header.magic != BinaryHeader{}.magic)
+    {
+        m_statistics.misses++;
+        return false;
+    }
+
+    // a truncated or corrupt file must not size the allocation
+
+    std::error_code error;
+    auto file_size = std::filesystem::file_size(path, error);
+    if (error || file_size < sizeof header || header.length > file_size - sizeof header)
+    {
+        m_statistics.misses++;
+        return false;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+    {
+        m_statistics.misses++;
+        return false;
+    }
+
+    glProgramBinary(program_, header.format, binary.data(), static_cast<int>(binary.size()));
+
+    int success = 0;
+    glGetProgramiv(program_, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        m_statistics.rejected++;
+        return false;
+    }
+
+    m_statistics.hits++;
+    return true;
+}
+
+//
+// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+// Written to a temporary file first, so a concurrent reader never sees a partial binary.
+// Each writer uses its own temporary file, which is removed if writing or renaming fails.
+//
+void ProgramBinaryCache::store(unsigned int program_, const std::string& key_)
+{
+    if (!m_is_enabled)
+        return;
+
+    int length = 0;
+    glGetProgramiv(program_, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program_, length, &length, &format, binary.data());
+
+    BinaryHeader header{ .format = format, .length = static_cast<std::uint32_t>(length) };
+
+    auto path = p_get_path(key_);
+    auto temporary = path;
+    temporary += make_temporary_suffix();
+
+    std::error_code error;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof header);
+        file.write(binary.data(), length);
+        file.close();
+        if (!file)
+        {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    m_statistics.stored++;
+}
+
+const ProgramBinaryCache::Statistics& ProgramBinaryCache::get_statistics() const
+{
+    return m_statistics;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::filesystem::path ProgramBinaryCache::p_get_path(const std::string& key_) const
+{
+    return m_directory / (key_ + ".bin");
+}
+
+}
+}
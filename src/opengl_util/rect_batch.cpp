@@ -0,0 +1,190 @@
+#include "opengl_util/rect_batch.h"
+
+#include "opengl_util/general.h"
+#include "tracing.h"
+
+#include <glad/gl.h>
+
+#include <cstring>
+
+namespace maple
+{
+namespace gl
+{
+
+void RectList::submit(const std::shared_ptr<Shader>& material_, const RectInstance& rect_)
+{
+    if (m_runs.empty() || m_runs.back().material != material_)
+        m_runs.push_back(Run{ .material = material_,
+                              .first    = static_cast<unsigned int>(m_instances.size()),
+                              .count    = 0 });
+
+    m_instances.push_back(rect_);
+    m_runs.back().count++;
+}
+
+void RectList::clear()
+{
+    m_instances.clear();
+    m_runs.clear();
+}
+
+bool RectList::is_empty() const
+{
+    return m_instances.empty();
+}
+
+const std::vector<RectInstance>& RectList::get_instances() const
+{
+    return m_instances;
+}
+
+const std::vector<RectList::Run>& RectList::get_runs() const
+{
+    return m_runs;
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+std::shared_ptr<RectBatch> RectBatch::create()
+{
+    struct MakeSharedEnabler : public RectBatch {};
+    return std::make_shared<MakeSharedEnabler>();
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+RectBatch::RectBatch()
+    : m_instance_buffer{ StreamBuffer::create(1024 * sizeof(RectInstance)) }
+{
+}
+
+RectBatch::~RectBatch()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// The quad corners are generated from gl_VertexID, so only the instance attributes are sourced from a buffer.
+// Must be called once for every OpenGL context, since vertex arrays are not shared between contexts.
+// The buffer itself is attached by flush, as its offset changes every frame.
+//
+void RectBatch::setup_vertex_array(VertexArray& va_)
+{
+    unsigned int va = va_.get_id();
+
+    glVertexArrayBindingDivisor(va, 0, 1);
+
+    glEnableVertexArrayAttrib(va, 0);
+    glVertexArrayAttribFormat(va, 0, 4, GL_FLOAT, GL_FALSE, offsetof(RectInstance, x));
+    glVertexArrayAttribBinding(va, 0, 0);
+
+    glEnableVertexArrayAttrib(va, 1);
+    glVertexArrayAttribFormat(va, 1, 4, GL_FLOAT, GL_FALSE, offsetof(RectInstance, r));
+    glVertexArrayAttribBinding(va, 1, 0);
+
+    glEnableVertexArrayAttrib(va, 2);
+    glVertexArrayAttribFormat(va, 2, 1, GL_FLOAT, GL_FALSE, offsetof(RectInstance, corner_radius));
+    glVertexArrayAttribBinding(va, 2, 0);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void RectBatch::begin()
+{
+    m_list.clear();
+    m_statistics = Statistics{};
+}
+
+void RectBatch::submit(const std::shared_ptr<Shader>& material_, const RectInstance& rect_)
+{
+    m_list.submit(material_, rect_);
+}
+
+void RectBatch::flush(VertexArray& va_, const Size& viewport_, const std::vector<Rect>& clip_rects_)
+{
+    flush(m_list, va_, viewport_, clip_rects_);
+    m_list.clear();
+}
+
+//
+// Writes every instance of the list into the stream buffer at once,
+// then issues one instanced draw call per material run.
+// With clip rects, every run is drawn once per rect under glScissor instead. The rects must not overlap,
+// otherwise blended rectangles would be drawn twice where they do.
+//
+void RectBatch::flush(const RectList& list_, VertexArray& va_, const Size& viewport_,
+                      const std::vector<Rect>& clip_rects_)
+{
+    if (list_.is_empty())
+        return;
+
+    MAPLE_TRACE_SCOPE("RectBatch::flush", "upload");
+
+    auto& instances = list_.get_instances();
+    std::size_t size = instances.size() * sizeof(RectInstance);
+    auto allocation = m_instance_buffer->allocate(size, sizeof(RectInstance));
+    std::memcpy(allocation.data, instances.data(), size);
+    m_statistics.uploaded_bytes += size;
+
+    glVertexArrayVertexBuffer(va_.get_id(), 0, m_instance_buffer->get_id(),
+                              allocation.offset, sizeof(RectInstance));
+
+    va_.bind();
+    for (auto& run : list_.get_runs())
+    {
+        run.material->bind();
+        run.material->set_uniform_vec2(p_get_viewport_uniform(run.material),
+                                       static_cast<float>(viewport_.width),
+                                       static_cast<float>(viewport_.height));
+
+        if (clip_rects_.empty())
+        {
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, run.count, run.first);
+            m_statistics.draw_calls++;
+            continue;
+        }
+
+        glEnable(GL_SCISSOR_TEST);
+        for (auto& clip : clip_rects_)
+        {
+            glScissor(clip.x, viewport_.height - clip.y - clip.height, clip.width, clip.height);
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, run.count, run.first);
+            m_statistics.draw_calls++;
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
+    m_statistics.instances += instances.size();
+    m_instance_buffer->fence();
+}
+
+const RectBatch::Statistics& RectBatch::get_statistics() const
+{
+    return m_statistics;
+}
+
+//
+// Every material must declare "uniform vec2 u_viewport". Its location is looked up on first use only.
+// Materials are held weakly so the batch does not keep destroyed shaders alive, and their entries are
+// dropped here once they expire. A program id could be reused by a new shader, so it is not used as the key.
+//
+UniformHandle RectBatch::p_get_viewport_uniform(const std::shared_ptr<Shader>& material_)
+{
+    std::erase_if(m_viewport_uniforms, [](const auto& entry_) { return entry_.first.expired(); });
+
+    for (auto& [material, location] : m_viewport_uniforms)
+        if (material.lock() == material_)
+            return UniformHandle{ .location = location };
+
+    auto handle = material_->get_uniform("u_viewport");
+    m_viewport_uniforms.emplace_back(material_, handle.location);
+    return handle;
+}
+
+}
+}
@@ -0,0 +1,217 @@
+#include "opengl_util/state_tracker.h"
+
+#include <glad/gl.h>
+
+#include <mutex>
+
+namespace maple
+{
+namespace gl
+{
+
+namespace
+{
+
+//
+// Every living tracker, so that deleting a shared object can be reflected in all contexts.
+//
+std::mutex trackers_mutex;
+std::vector<StateTracker*> trackers;
+
+thread_local StateTracker* current_tracker = nullptr;
+
+}
+
+std::shared_ptr<StateTracker> StateTracker::create()
+{
+    struct MakeSharedEnabler : public StateTracker {};
+    return std::make_shared<MakeSharedEnabler>();
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+StateTracker::StateTracker()
+{
+    invalidate();
+
+    std::lock_guard lock(trackers_mutex);
+    trackers.push_back(this);
+}
+
+StateTracker::~StateTracker()
+{
+    std::lock_guard lock(trackers_mutex);
+    std::erase(trackers, this);
+
+    if (current_tracker == this)
+        current_tracker = nullptr;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void StateTracker::make_current(StateTracker* tracker_)
+{
+    current_tracker = tracker_;
+}
+
+StateTracker& StateTracker::get_current()
+{
+    if (current_tracker)
+        return *current_tracker;
+
+    thread_local std::shared_ptr<StateTracker> fallback = create();
+    return *fallback;
+}
+
+void StateTracker::forget_buffer(unsigned int id_)
+{
+    std::lock_guard lock(trackers_mutex);
+    for (auto* tracker : trackers)
+        for (auto& buffer : tracker->m_buffers)
+            p_forget(buffer, id_);
+}
+
+void StateTracker::forget_vertex_array(unsigned int id_)
+{
+    std::lock_guard lock(trackers_mutex);
+    for (auto* tracker : trackers)
+        p_forget(tracker->m_vertex_array, id_);
+}
+
+void StateTracker::forget_program(unsigned int id_)
+{
+    std::lock_guard lock(trackers_mutex);
+    for (auto* tracker : trackers)
+        p_forget(tracker->m_program, id_);
+}
+
+void StateTracker::forget_framebuffer(unsigned int id_)
+{
+    std::lock_guard lock(trackers_mutex);
+    for (auto* tracker : trackers)
+    {
+        p_forget(tracker->m_draw_framebuffer, id_);
+        p_forget(tracker->m_read_framebuffer, id_);
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Targets that are not tracked, such as GL_ELEMENT_ARRAY_BUFFER which belongs to the vertex array,
+// are always passed through.
+//
+void StateTracker::bind_buffer(unsigned int target_, unsigned int id_)
+{
+    int slot = p_get_buffer_slot(target_);
+    if (slot >= 0)
+    {
+        if (m_buffers[slot].load(std::memory_order_acquire) == id_)
+        {
+            m_statistics.skipped++;
+            return;
+        }
+        m_buffers[slot].store(id_, std::memory_order_release);
+    }
+
+    glBindBuffer(target_, id_);
+    m_statistics.issued++;
+}
+
+void StateTracker::bind_vertex_array(unsigned int id_)
+{
+    if (m_vertex_array.load(std::memory_order_acquire) == id_)
+    {
+        m_statistics.skipped++;
+        return;
+    }
+
+    m_vertex_array.store(id_, std::memory_order_release);
+    glBindVertexArray(id_);
+    m_statistics.issued++;
+}
+
+void StateTracker::use_program(unsigned int id_)
+{
+    if (m_program.load(std::memory_order_acquire) == id_)
+    {
+        m_statistics.skipped++;
+        return;
+    }
+
+    m_program.store(id_, std::memory_order_release);
+    glUseProgram(id_);
+    m_statistics.issued++;
+}
+
+//
+// GL_FRAMEBUFFER sets both the draw and the read binding, and is only skipped when both are current.
+//
+void StateTracker::bind_framebuffer(unsigned int target_, unsigned int id_)
+{
+    bool is_draw = target_ == GL_FRAMEBUFFER || target_ == GL_DRAW_FRAMEBUFFER;
+    bool is_read = target_ == GL_FRAMEBUFFER || target_ == GL_READ_FRAMEBUFFER;
+    if ((!is_draw || m_draw_framebuffer.load(std::memory_order_acquire) == id_)
+        && (!is_read || m_read_framebuffer.load(std::memory_order_acquire) == id_))
+    {
+        m_statistics.skipped++;
+        return;
+    }
+
+    if (is_draw)
+        m_draw_framebuffer.store(id_, std::memory_order_release);
+    if (is_read)
+        m_read_framebuffer.store(id_, std::memory_order_release);
+    glBindFramebuffer(target_, id_);
+    m_statistics.issued++;
+}
+
+//
+// Call after OpenGL state was changed without going through the tracker.
+//
+void StateTracker::invalidate()
+{
+    for (auto& buffer : m_buffers)
+        buffer.store(unknown, std::memory_order_release);
+    m_vertex_array.store(unknown, std::memory_order_release);
+    m_program.store(unknown, std::memory_order_release);
+    m_draw_framebuffer.store(unknown, std::memory_order_release);
+    m_read_framebuffer.store(unknown, std::memory_order_release);
+}
+
+const StateTracker::Statistics& StateTracker::get_statistics() const
+{
+    return m_statistics;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Only clears the binding if it still holds the deleted name, so a bind of another object
+// by the owning thread in the meantime is kept.
+//
+void StateTracker::p_forget(Binding& binding_, unsigned int id_)
+{
+    unsigned int expected = id_;
+    binding_.compare_exchange_strong(expected, unknown, std::memory_order_acq_rel);
+}
+
+int StateTracker::p_get_buffer_slot(unsigned int target_)
+{
+    switch (target_)
+    {
+    case GL_ARRAY_BUFFER:           return array_buffer;
+    case GL_PIXEL_PACK_BUFFER:      return pixel_pack_buffer;
+    case GL_PIXEL_UNPACK_BUFFER:    return pixel_unpack_buffer;
+    case GL_UNIFORM_BUFFER:         return uniform_buffer;
+    case GL_COPY_READ_BUFFER:       return copy_read_buffer;
+    case GL_COPY_WRITE_BUFFER:      return copy_write_buffer;
+    case GL_DRAW_INDIRECT_BUFFER:   return draw_indirect_buffer;
+    default:                        return -1;
+    }
+}
+
+}
+}
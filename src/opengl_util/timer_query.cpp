@@ -0,0 +1,148 @@
+#include "opengl_util/timer_query.h"
+
+#include <glad/gl.h>
+
+namespace maple
+{
+namespace gl
+{
+
+std::shared_ptr<TimerQueryPool> TimerQueryPool::create(std::size_t frames_in_flight_, std::size_t max_passes_)
+{
+    struct MakeSharedEnabler : public TimerQueryPool {
+        MakeSharedEnabler(std::size_t frames_in_flight_, std::size_t max_passes_)
+            : TimerQueryPool(frames_in_flight_, max_passes_) {}
+    };
+    return std::make_shared<MakeSharedEnabler>(frames_in_flight_, max_passes_);
+}
+
+// ====================================================================================================================
+//
+// ====================================================================================================================
+
+TimerQueryPool::TimerQueryPool(std::size_t frames_in_flight_, std::size_t max_passes_)
+    : m_slots(std::max<std::size_t>(frames_in_flight_, 1)),
+      m_next{ 0 },
+      m_recording{ nullptr },
+      m_is_pass_open{ false }
+{
+    for (auto& slot : m_slots)
+    {
+        slot.queries.resize(std::max<std::size_t>(max_passes_, 1) * 2);
+        glCreateQueries(GL_TIMESTAMP, static_cast<int>(slot.queries.size()), slot.queries.data());
+        slot.passes.reserve(max_passes_);
+    }
+}
+
+TimerQueryPool::~TimerQueryPool()
+{
+    for (auto& slot : m_slots)
+        glDeleteQueries(static_cast<int>(slot.queries.size()), slot.queries.data());
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Returns false when every slot is still waiting for the GPU. The passes of that frame are then ignored.
+//
+bool TimerQueryPool::begin_frame(std::uint64_t frame_)
+{
+    Slot& slot = m_slots[m_next];
+    if (slot.is_pending)
+    {
+        m_statistics.dropped_frames++;
+        m_recording = nullptr;
+        return false;
+    }
+
+    slot.frame = frame_;
+    slot.passes.clear();
+    m_recording = &slot;
+    return true;
+}
+
+//
+// Passes cannot be nested. Passes beyond the capacity of a slot are not timed.
+//
+void TimerQueryPool::begin_pass(unsigned int pass_)
+{
+    if (!m_recording)
+        return;
+
+    if (m_recording->passes.size() * 2 >= m_recording->queries.size())
+    {
+        m_statistics.dropped_passes++;
+        return;
+    }
+
+    std::size_t index = m_recording->passes.size() * 2;
+    Pass pass{ .pass = pass_, .start = m_recording->queries[index], .end = m_recording->queries[index + 1] };
+    glQueryCounter(pass.start, GL_TIMESTAMP);
+    m_recording->passes.push_back(pass);
+    m_is_pass_open = true;
+}
+
+void TimerQueryPool::end_pass()
+{
+    if (!m_recording || !m_is_pass_open)
+        return;
+
+    glQueryCounter(m_recording->passes.back().end, GL_TIMESTAMP);
+    m_is_pass_open = false;
+}
+
+void TimerQueryPool::end_frame()
+{
+    if (!m_recording)
+        return;
+
+    end_pass();
+    if (!m_recording->passes.empty())
+    {
+        m_recording->is_pending = true;
+        m_next = (m_next + 1) % m_slots.size();
+        m_statistics.timed_frames++;
+    }
+    m_recording = nullptr;
+}
+
+//
+// Appends the passes of every frame whose queries completed, oldest frame first, and never blocks.
+// Queries complete in submission order, so the availability of the last query of a slot covers the whole slot.
+//
+std::size_t TimerQueryPool::collect(std::vector<Result>& results_)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < m_slots.size(); i++)
+    {
+        Slot& slot = m_slots[(m_next + i) % m_slots.size()];
+        if (!slot.is_pending)
+            continue;
+
+        unsigned int is_available = 0;
+        glGetQueryObjectuiv(slot.passes.back().end, GL_QUERY_RESULT_AVAILABLE, &is_available);
+        if (!is_available)
+            break;
+
+        for (auto& pass : slot.passes)
+        {
+            std::uint64_t start = 0, end = 0;
+            glGetQueryObjectui64v(pass.start, GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(pass.end, GL_QUERY_RESULT, &end);
+            results_.push_back(Result{ .frame    = slot.frame,
+                                       .pass     = pass.pass,
+                                       .duration = std::chrono::nanoseconds(end - start) });
+            count++;
+        }
+        slot.is_pending = false;
+    }
+    return count;
+}
+
+const TimerQueryPool::Statistics& TimerQueryPool::get_statistics() const
+{
+    return m_statistics;
+}
+
+}
+}
@@ -0,0 +1,54 @@
+#include "painter.h"
+
+#include "damage_region.h"
+#include "opengl_util/rect_batch.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//     CLASS: Painter
+// ====================================================================================================================
+
+Painter::Painter(gl::RectList& list_, const std::shared_ptr<gl::Shader>& material_, const Size& size_,
+                 const DamageRegion& damage_)
+    : m_list{ list_ },
+      m_material{ material_ },
+      m_size{ size_ },
+      m_damage{ damage_ }
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void Painter::fill_rect(const Rect& rect_, const Color& color_, float corner_radius_)
+{
+    if (!m_damage.intersects(rect_))
+        return;
+
+    m_list.submit(m_material,
+                  gl::RectInstance{
+                      .x             = static_cast<float>(rect_.x),
+                      .y             = static_cast<float>(rect_.y),
+                      .width         = static_cast<float>(rect_.width),
+                      .height        = static_cast<float>(rect_.height),
+                      .r             = color_.r,
+                      .g             = color_.g,
+                      .b             = color_.b,
+                      .a             = color_.a,
+                      .corner_radius = corner_radius_
+                  });
+}
+
+Size Painter::get_size() const
+{
+    return m_size;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,314 @@
+#include "surface.h"
+
+#include "opengl_util/general.h"
+
+#include <glad/gl.h>
+
+#ifdef MAPLE_HAS_EGL
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+
+
+#ifdef MAPLE_HAS_EGL
+
+namespace
+{
+
+
+
+// ====================================================================================================================
+//      INTERNAL CLASS: LibEGLInitializer
+// ====================================================================================================================
+
+//
+// Initialize an EGL display that needs no window system and load OpenGL functions using Glad.
+// Prefers Mesa's surfaceless platform, which also works with llvmpipe on machines without a GPU,
+// and falls back to the default display otherwise.
+// Once initialized, it will be valid until the end of program.
+//
+class LibEGLInitializer
+{
+public:
+    LibEGLInitializer();
+    ~LibEGLInitializer();
+
+    void initialize();
+
+    bool is_initialized() const;
+
+    EGLDisplay get_display() const;
+
+    EGLContext create_context(EGLContext share_) const;
+
+private:
+    static GLADapiproc load_function(const char* name_);
+
+    bool m_is_initialized;
+    EGLDisplay m_display;
+    EGLConfig m_config;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+LibEGLInitializer lib_egl_initializer;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+LibEGLInitializer::LibEGLInitializer()
+    : m_is_initialized{ false },
+      m_display{ EGL_NO_DISPLAY },
+      m_config{ nullptr }
+{
+}
+
+LibEGLInitializer::~LibEGLInitializer()
+{
+    if (!is_initialized())
+        return;
+
+    eglTerminate(m_display);
+    m_is_initialized = false;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void LibEGLInitializer::initialize()
+{
+    if (is_initialized())
+        return;
+
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (client_extensions && get_platform_display
+        && std::string_view(client_extensions).find("EGL_MESA_platform_surfaceless") != std::string_view::npos)
+        m_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    else
+        m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, nullptr, nullptr))
+        throw std::runtime_error("void LibEGLInitializer::initialize(): "
+                                 "Failed to initialize EGL. eglInitialize()");
+
+    std::string_view extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+    if (extensions.find("EGL_KHR_surfaceless_context") == std::string_view::npos)
+        throw std::runtime_error("void LibEGLInitializer::initialize(): "
+                                 "EGL_KHR_surfaceless_context is not supported. eglQueryString()");
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+        throw std::runtime_error("void LibEGLInitializer::initialize(): "
+                                 "Failed to bind the OpenGL API. eglBindAPI()");
+
+    if (extensions.find("EGL_KHR_no_config_context") == std::string_view::npos)
+    {
+        EGLint attributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLint count = 0;
+        if (!eglChooseConfig(m_display, attributes, &m_config, 1, &count) || count == 0)
+            throw std::runtime_error("void LibEGLInitializer::initialize(): "
+                                     "Failed to find an OpenGL config. eglChooseConfig()");
+    }
+
+    EGLContext dummy = create_context(EGL_NO_CONTEXT);
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, dummy);
+    if (!gladLoadGL(load_function))
+        throw std::runtime_error("void LibEGLInitializer::initialize(): "
+                                 "Failed to create opengl context. gladLoadGL()");
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(m_display, dummy);
+
+    m_is_initialized = true;
+}
+
+bool LibEGLInitializer::is_initialized() const
+{
+    return m_is_initialized;
+}
+
+EGLDisplay LibEGLInitializer::get_display() const
+{
+    return m_display;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+EGLContext LibEGLInitializer::create_context(EGLContext share_) const
+{
+    EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,          maple::configuration::opengl_version_major,
+        EGL_CONTEXT_MINOR_VERSION,          maple::configuration::opengl_version_minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    EGLContext context = eglCreateContext(m_display, m_config, share_, attributes);
+    if (context == EGL_NO_CONTEXT)
+        throw std::runtime_error("EGLContext LibEGLInitializer::create_context(): "
+                                 "Failed to create opengl context. eglCreateContext()");
+    return context;
+}
+
+GLADapiproc LibEGLInitializer::load_function(const char* name_)
+{
+    return reinterpret_cast<GLADapiproc>(eglGetProcAddress(name_));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+
+
+// ====================================================================================================================
+//      INTERNAL CLASS: HeadlessSurface
+// ====================================================================================================================
+
+//
+// A surfaceless EGL context. Sized surfaces render into their own framebuffer object,
+// which takes the place of the window's default framebuffer, so presenting is only a flush.
+//
+class HeadlessSurface : public maple::platform::Surface
+{
+public:
+    HeadlessSurface(const maple::Size& size_, Surface* share_);
+    virtual ~HeadlessSurface() override;
+
+    virtual void show() override;
+    virtual void swap_buffers() override;
+    virtual void request_close() override;
+    virtual bool is_close_requested() override;
+    virtual void cancel_close() override;
+
+    virtual maple::Size get_framebuffer_size() override;
+    virtual unsigned int get_framebuffer_id() override;
+
+    EGLContext get_context() const;
+
+protected:
+    virtual void p_make_current() override;
+    virtual void p_release_current() override;
+
+private:
+    EGLContext m_context;
+    std::shared_ptr<maple::gl::Framebuffer> m_framebuffer;
+    maple::Size m_size;
+    bool m_is_close_requested;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+HeadlessSurface::HeadlessSurface(const maple::Size& size_, Surface* share_)
+    : m_context{ EGL_NO_CONTEXT },
+      m_framebuffer{ nullptr },
+      m_size{ size_ },
+      m_is_close_requested{ false }
+{
+    if (!lib_egl_initializer.is_initialized())
+        lib_egl_initializer.initialize();
+
+    auto* share = dynamic_cast<HeadlessSurface*>(share_);
+    m_context = lib_egl_initializer.create_context(share ? share->get_context() : EGL_NO_CONTEXT);
+
+    if (m_size.width > 0 && m_size.height > 0)
+    {
+        make_current();
+        m_framebuffer = maple::gl::Framebuffer::create(m_size);
+    }
+}
+
+HeadlessSurface::~HeadlessSurface()
+{
+    if (m_framebuffer)
+    {
+        make_current();
+        m_framebuffer.reset();
+    }
+
+    EGLDisplay display = lib_egl_initializer.get_display();
+    if (eglGetCurrentContext() == m_context)
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, m_context);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void HeadlessSurface::show()
+{
+}
+
+void HeadlessSurface::swap_buffers()
+{
+    glFlush();
+}
+
+void HeadlessSurface::request_close()
+{
+    m_is_close_requested = true;
+}
+
+bool HeadlessSurface::is_close_requested()
+{
+    return m_is_close_requested;
+}
+
+void HeadlessSurface::cancel_close()
+{
+    m_is_close_requested = false;
+}
+
+maple::Size HeadlessSurface::get_framebuffer_size()
+{
+    return m_size;
+}
+
+unsigned int HeadlessSurface::get_framebuffer_id()
+{
+    return m_framebuffer ? m_framebuffer->get_id() : 0;
+}
+
+EGLContext HeadlessSurface::get_context() const
+{
+    return m_context;
+}
+
+//
+// The bound client API is per thread, so it is bound again in case this thread never did.
+//
+void HeadlessSurface::p_make_current()
+{
+    eglBindAPI(EGL_OPENGL_API);
+    eglMakeCurrent(lib_egl_initializer.get_display(), EGL_NO_SURFACE, EGL_NO_SURFACE, m_context);
+}
+
+void HeadlessSurface::p_release_current()
+{
+    eglBindAPI(EGL_OPENGL_API);
+    eglMakeCurrent(lib_egl_initializer.get_display(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
+
+#endif
+
+
+
+namespace maple
+{
+namespace platform
+{
+
+std::unique_ptr<Surface> Surface::create_headless(const Size& size_, Surface* share_)
+{
+#ifdef MAPLE_HAS_EGL
+    return std::make_unique<HeadlessSurface>(size_, share_);
+#else
+    (void)size_;
+    (void)share_;
+    throw std::runtime_error("std::unique_ptr<Surface> Surface::create_headless(): "
+                             "MapleUI was built without EGL, headless contexts are not available.");
+#endif
+}
+
+}
+}
@@ -0,0 +1,248 @@
+#include "surface.h"
+
+#include <glad/gl.h>
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+
+
+namespace
+{
+
+
+
+// ====================================================================================================================
+//      INTERNAL CLASS: LibGLFWInitializer
+// ====================================================================================================================
+
+//
+// Initialize the GLFW library and load OpenGL functions using Glad.
+// Once initialized, it will be valid until the end of program.
+//
+class LibGLFWInitializer
+{
+public:
+    LibGLFWInitializer();
+    ~LibGLFWInitializer();
+
+    void initialize();
+
+    bool is_initialized() const;
+
+private:
+    static void error_callback(int error_code_, const char* description_);
+
+    bool m_is_initialized;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+LibGLFWInitializer lib_glfw_initializer;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+LibGLFWInitializer::LibGLFWInitializer()
+    : m_is_initialized{ false }
+{
+}
+
+LibGLFWInitializer::~LibGLFWInitializer()
+{
+    if (!is_initialized())
+        return;
+
+    glfwTerminate();
+    m_is_initialized = false;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void LibGLFWInitializer::initialize()
+{
+    if (is_initialized())
+        return;
+
+    glfwSetErrorCallback(error_callback);
+
+    if (!glfwInit())
+    throw std::runtime_error("void LibGLFWInitializer::initialize(): "
+                             "Failed to initialize GLFW. glfwInit()");
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
+                   maple::configuration::opengl_version_major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
+                   maple::configuration::opengl_version_minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* dummy = glfwCreateWindow(100, 100,
+                                         "", nullptr, nullptr);
+    if (!dummy)
+        throw std::runtime_error("void LibGLFWInitializer::initialize(): "
+                                 "Failed to create window. glfwCreateWindow()");
+    glfwMakeContextCurrent(dummy);
+    if (!gladLoadGL(glfwGetProcAddress))
+        throw std::runtime_error("void LibGLFWInitializer::initialize(): "
+                                 "Failed to create opengl context. gladLoadGL()");
+    glfwDestroyWindow(dummy);
+
+    m_is_initialized = true;
+}
+
+bool LibGLFWInitializer::is_initialized() const
+{
+    return m_is_initialized;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void LibGLFWInitializer::error_callback(int error_code_, const char* description_)
+{
+    std::cerr << "GLFW error callback: [ " << error_code_ << " ] "
+              << description_ << "\n";
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+
+
+// ====================================================================================================================
+//      INTERNAL CLASS: GLFWSurface
+// ====================================================================================================================
+
+//
+// A GLFW window and its OpenGL context. Windows are created hidden and shown by show.
+//
+class GLFWSurface : public maple::platform::Surface
+{
+public:
+    GLFWSurface(const maple::Size& size_, const std::string& title_, Surface* share_);
+    virtual ~GLFWSurface() override;
+
+    virtual void show() override;
+    virtual void swap_buffers() override;
+    virtual void request_close() override;
+    virtual bool is_close_requested() override;
+    virtual void cancel_close() override;
+
+    virtual maple::Size get_framebuffer_size() override;
+    virtual unsigned int get_framebuffer_id() override;
+
+    virtual void set_swap_interval(int interval_) override;
+
+    virtual GLFWwindow* get_glfw_handle() override;
+
+protected:
+    virtual void p_make_current() override;
+    virtual void p_release_current() override;
+
+private:
+    GLFWwindow* m_handle;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+GLFWSurface::GLFWSurface(const maple::Size& size_, const std::string& title_, Surface* share_)
+    : m_handle{ nullptr }
+{
+    if (!lib_glfw_initializer.is_initialized())
+        lib_glfw_initializer.initialize();
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
+                   maple::configuration::opengl_version_major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
+                   maple::configuration::opengl_version_minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    m_handle = glfwCreateWindow(std::max(size_.width, 1), std::max(size_.height, 1),
+                                title_.c_str(),
+                                nullptr,
+                                share_ ? share_->get_glfw_handle() : nullptr);
+    if (!m_handle)
+        throw std::runtime_error("void GLFWSurface::GLFWSurface(): "
+                                 "Failed to create window. glfwCreateWindow()");
+}
+
+GLFWSurface::~GLFWSurface()
+{
+    glfwDestroyWindow(m_handle);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void GLFWSurface::show()
+{
+    glfwShowWindow(m_handle);
+}
+
+void GLFWSurface::swap_buffers()
+{
+    glfwSwapBuffers(m_handle);
+}
+
+void GLFWSurface::request_close()
+{
+    glfwSetWindowShouldClose(m_handle, GLFW_TRUE);
+}
+
+bool GLFWSurface::is_close_requested()
+{
+    return static_cast<bool>(glfwWindowShouldClose(m_handle));
+}
+
+void GLFWSurface::cancel_close()
+{
+    glfwSetWindowShouldClose(m_handle, GLFW_FALSE);
+}
+
+maple::Size GLFWSurface::get_framebuffer_size()
+{
+    maple::Size size;
+    glfwGetFramebufferSize(m_handle, &size.width, &size.height);
+    return size;
+}
+
+unsigned int GLFWSurface::get_framebuffer_id()
+{
+    return 0;
+}
+
+void GLFWSurface::set_swap_interval(int interval_)
+{
+    glfwSwapInterval(interval_);
+}
+
+GLFWwindow* GLFWSurface::get_glfw_handle()
+{
+    return m_handle;
+}
+
+void GLFWSurface::p_make_current()
+{
+    glfwMakeContextCurrent(m_handle);
+}
+
+void GLFWSurface::p_release_current()
+{
+    glfwMakeContextCurrent(nullptr);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
+
+
+
+namespace maple
+{
+namespace platform
+{
+
+std::unique_ptr<Surface> Surface::create_window(const Size& size_, const std::string& title_, Surface* share_)
+{
+    return std::make_unique<GLFWSurface>(size_, title_, share_);
+}
+
+}
+}
@@ -0,0 +1,69 @@
+#include "surface.h"
+
+#include "opengl_util/state_tracker.h"
+
+
+
+namespace maple
+{
+namespace platform
+{
+
+
+
+// ====================================================================================================================
+//      INTERNAL CLASS: Surface
+// ====================================================================================================================
+
+Surface::Surface()
+    : m_state_tracker{ gl::StateTracker::create() }
+{
+}
+
+Surface::~Surface()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Every OpenGL context switch goes through here,
+// so that the StateTracker shadowing the context becomes current together with it.
+//
+void Surface::make_current()
+{
+    p_make_current();
+    gl::StateTracker::make_current(m_state_tracker.get());
+}
+
+//
+// Leaves the calling thread without a current context.
+//
+void Surface::release_current()
+{
+    p_release_current();
+    gl::StateTracker::make_current(nullptr);
+}
+
+gl::StateTracker& Surface::get_state_tracker()
+{
+    return *m_state_tracker;
+}
+
+//
+// Surfaces that do not present to a display have nothing to wait for, so this does nothing by default.
+// The surface must be current.
+//
+void Surface::set_swap_interval(int)
+{
+}
+
+GLFWwindow* Surface::get_glfw_handle()
+{
+    return nullptr;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
+}
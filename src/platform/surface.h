@@ -0,0 +1,63 @@
+#pragma once
+#include "define.h"
+
+struct GLFWwindow;
+
+namespace maple
+{
+namespace gl
+{
+    class StateTracker;
+}
+namespace platform
+{
+
+// ====================================================================================================================
+//      INTERNAL CLASS: Surface
+// ====================================================================================================================
+
+//
+// An OpenGL context together with whatever it presents to.
+// Either a GLFW window, or a surfaceless EGL context that renders into a framebuffer object for headless use.
+// Every surface owns the StateTracker shadowing its context, and make_current switches both at once.
+// A context can only be current on one thread, so a thread hands it over with release_current.
+// Surfaces created without a size are only used as the hidden context owning shared objects.
+//
+class Surface
+{
+public:
+    static std::unique_ptr<Surface> create_window(const Size& size_, const std::string& title_, Surface* share_);
+    static std::unique_ptr<Surface> create_headless(const Size& size_, Surface* share_);
+
+    virtual ~Surface();
+
+    void make_current();
+    void release_current();
+    gl::StateTracker& get_state_tracker();
+
+    virtual void show() = 0;
+    virtual void swap_buffers() = 0;
+    virtual void request_close() = 0;
+    virtual bool is_close_requested() = 0;
+    virtual void cancel_close() = 0;
+
+    virtual Size get_framebuffer_size() = 0;
+    virtual unsigned int get_framebuffer_id() = 0;
+
+    virtual void set_swap_interval(int interval_);
+
+    virtual GLFWwindow* get_glfw_handle();
+
+protected:
+    Surface();
+
+    virtual void p_make_current() = 0;
+    virtual void p_release_current() = 0;
+
+    std::shared_ptr<gl::StateTracker> m_state_tracker;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
+}
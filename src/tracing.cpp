@@ -0,0 +1,377 @@
+#include "tracing.h"
+
+
+
+namespace
+{
+
+
+
+// ====================================================================================================================
+//      per-thread event buffers used by Tracer
+// ====================================================================================================================
+
+struct Event
+{
+    const char* name{ nullptr };
+    const char* category{ nullptr };
+    std::int64_t start{ 0 };
+    std::int64_t duration{ 0 };
+};
+
+struct Chunk
+{
+    static constexpr std::size_t capacity = 4096;
+
+    std::array<Event, capacity> events{};
+    std::atomic<std::size_t> count{ 0 };
+    std::atomic<Chunk*> next{ nullptr };
+};
+
+//
+// Linked chunks with a single producer, the thread that owns the buffer, and a single consumer,
+// the thread flushing under the state mutex. The producer only touches its tail chunk,
+// so the consumer may delete every chunk it has fully read.
+//
+struct ThreadBuffer
+{
+    ThreadBuffer(int thread_id_);
+    ~ThreadBuffer();
+
+    void push(const Event& event_);
+
+    template <typename Function>
+    void drain(Function&& function_);
+
+    const int thread_id;
+    std::atomic<bool> is_thread_alive{ true };
+
+    // guarded by the state mutex
+    std::string thread_name;
+    bool is_named_in_file{ false };
+
+private:
+    Chunk* m_head;
+    std::size_t m_read;
+    Chunk* m_tail;
+};
+
+ThreadBuffer::ThreadBuffer(int thread_id_)
+    : thread_id{ thread_id_ },
+      m_head{ new Chunk },
+      m_read{ 0 }
+{
+    m_tail = m_head;
+}
+
+ThreadBuffer::~ThreadBuffer()
+{
+    while (m_head)
+        delete std::exchange(m_head, m_head->next.load());
+}
+
+void ThreadBuffer::push(const Event& event_)
+{
+    std::size_t count = m_tail->count.load(std::memory_order_relaxed);
+    if (count == Chunk::capacity)
+    {
+        Chunk* chunk = new Chunk;
+        m_tail->next.store(chunk, std::memory_order_release);
+        m_tail = chunk;
+        count = 0;
+    }
+
+    m_tail->events[count] = event_;
+    m_tail->count.store(count + 1, std::memory_order_release);
+}
+
+template <typename Function>
+void ThreadBuffer::drain(Function&& function_)
+{
+    while (true)
+    {
+        std::size_t count = m_head->count.load(std::memory_order_acquire);
+        for (; m_read < count; m_read++)
+            function_(m_head->events[m_read]);
+
+        if (m_read < Chunk::capacity)
+            return;
+
+        Chunk* next = m_head->next.load(std::memory_order_acquire);
+        if (!next)
+            return;
+        delete std::exchange(m_head, next);
+        m_read = 0;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct TraceState
+{
+    ~TraceState();
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    int next_thread_id{ 1 };
+
+    std::atomic<bool> is_active{ false };
+    std::ofstream file;
+    bool is_first_event{ true };
+    std::int64_t origin{ 0 };
+
+    maple::Tracer::Statistics statistics{};
+};
+
+//
+// Constructed on first use, so it outlives every thread_local buffer holder and completes the file at exit.
+//
+TraceState& get_state()
+{
+    static TraceState state;
+    return state;
+}
+
+//
+// Registers the buffer of the calling thread on first use. The buffer stays registered after the thread exits
+// until its remaining events are flushed.
+//
+struct ThreadBufferHolder
+{
+    ThreadBufferHolder()
+    {
+        auto& state = get_state();
+        std::lock_guard lock(state.mutex);
+        buffer = std::make_shared<ThreadBuffer>(state.next_thread_id++);
+        state.buffers.push_back(buffer);
+    }
+
+    ~ThreadBufferHolder()
+    {
+        buffer->is_thread_alive = false;
+    }
+
+    std::shared_ptr<ThreadBuffer> buffer;
+};
+
+ThreadBuffer& get_thread_buffer()
+{
+    thread_local ThreadBufferHolder holder;
+    return *holder.buffer;
+}
+
+std::int64_t to_nanoseconds(maple::Tracer::Clock::time_point time_)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time_.time_since_epoch()).count();
+}
+
+void write_string(std::ostream& stream_, std::string_view text_)
+{
+    stream_ << '"';
+    for (char c : text_)
+    {
+        if (c == '"' || c == '\\')
+            stream_ << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            stream_ << ' ';
+        else
+            stream_ << c;
+    }
+    stream_ << '"';
+}
+
+//
+// Writes the events of every buffer, or discards them when the file is not open. Must hold the state mutex.
+//
+void drain_buffers(TraceState& state_)
+{
+    auto begin_event = [&state_]
+        {
+            state_.file << (state_.is_first_event ? "\n" : ",\n");
+            state_.is_first_event = false;
+        };
+
+    for (auto& buffer : state_.buffers)
+    {
+        // checked before draining, so events pushed right before the thread exited are not lost
+        bool is_thread_alive = buffer->is_thread_alive;
+        if (!state_.file.is_open())
+        {
+            buffer->drain([](const Event&) {});
+            if (!is_thread_alive)
+                buffer.reset();
+            continue;
+        }
+
+        if (!buffer->is_named_in_file && !buffer->thread_name.empty())
+        {
+            begin_event();
+            state_.file << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->thread_id
+                        << R"(,"args":{"name":)";
+            write_string(state_.file, buffer->thread_name);
+            state_.file << "}}";
+            buffer->is_named_in_file = true;
+        }
+
+        buffer->drain([&](const Event& event_)
+            {
+                if (event_.start < state_.origin)
+                    return;
+
+                begin_event();
+                state_.file << R"({"name":)";
+                write_string(state_.file, event_.name);
+                state_.file << R"(,"cat":)";
+                write_string(state_.file, event_.category);
+                state_.file << R"(,"ph":"X","ts":)" << (event_.start - state_.origin) / 1000.0
+                            << R"(,"dur":)" << event_.duration / 1000.0
+                            << R"(,"pid":1,"tid":)" << buffer->thread_id << "}";
+                state_.statistics.events++;
+            });
+        if (!is_thread_alive)
+            buffer.reset();
+    }
+
+    std::erase(state_.buffers, nullptr);
+}
+
+//
+// Completes the file. Must hold the state mutex.
+//
+void stop_tracing(TraceState& state_)
+{
+    if (!state_.file.is_open())
+        return;
+
+    state_.is_active = false;
+    drain_buffers(state_);
+    state_.file << "\n]}\n";
+    state_.file.close();
+    state_.statistics.flushes++;
+}
+
+TraceState::~TraceState()
+{
+    std::lock_guard lock(mutex);
+    stop_tracing(*this);
+}
+
+}
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//     CLASS: Tracer
+// ====================================================================================================================
+
+//
+// Events recorded before start are discarded. Starting while active completes the previous file first.
+//
+void Tracer::start(const std::filesystem::path& path_)
+{
+    auto& state = get_state();
+    std::lock_guard lock(state.mutex);
+
+    stop_tracing(state);
+    drain_buffers(state);
+    for (auto& buffer : state.buffers)
+        buffer->is_named_in_file = false;
+
+    state.file.open(path_, std::ios::trunc);
+    if (!state.file)
+        throw std::runtime_error("void Tracer::start(const std::filesystem::path&): Failed to open trace file.");
+
+    state.file << std::fixed;
+    state.file.precision(3);
+    state.file << R"({"displayTimeUnit":"ms","traceEvents":[)";
+    state.is_first_event = true;
+    state.origin = to_nanoseconds(Clock::now());
+    state.statistics = Statistics{};
+    state.is_active = true;
+}
+
+//
+// Writes every event recorded so far. Cheap enough to call once per second or so during a long capture.
+//
+void Tracer::flush()
+{
+    auto& state = get_state();
+    std::lock_guard lock(state.mutex);
+    if (!state.file.is_open())
+        return;
+
+    drain_buffers(state);
+    state.file.flush();
+    state.statistics.flushes++;
+}
+
+void Tracer::stop()
+{
+    auto& state = get_state();
+    std::lock_guard lock(state.mutex);
+    stop_tracing(state);
+}
+
+bool Tracer::is_active()
+{
+    return get_state().is_active.load(std::memory_order_relaxed);
+}
+
+//
+// Names the calling thread in the trace.
+//
+void Tracer::set_thread_name(const std::string& name_)
+{
+    auto& buffer = get_thread_buffer();
+
+    auto& state = get_state();
+    std::lock_guard lock(state.mutex);
+    buffer.thread_name = name_;
+    buffer.is_named_in_file = false;
+}
+
+void Tracer::record(const char* name_, const char* category_, Clock::time_point start_, Clock::time_point end_)
+{
+    if (!is_active())
+        return;
+
+    std::int64_t start = to_nanoseconds(start_);
+    get_thread_buffer().push(Event{ .name     = name_,
+                                    .category = category_,
+                                    .start    = start,
+                                    .duration = to_nanoseconds(end_) - start });
+}
+
+Tracer::Statistics Tracer::get_statistics()
+{
+    auto& state = get_state();
+    std::lock_guard lock(state.mutex);
+    return state.statistics;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+TraceScope::TraceScope(const char* name_, const char* category_)
+    : m_name{ name_ },
+      m_category{ category_ },
+      m_start{},
+      m_is_active{ Tracer::is_active() }
+{
+    if (m_is_active)
+        m_start = Tracer::Clock::now();
+}
+
+TraceScope::~TraceScope()
+{
+    if (m_is_active)
+        Tracer::record(m_name, m_category, m_start, Tracer::Clock::now());
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
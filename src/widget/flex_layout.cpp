@@ -0,0 +1,316 @@
+#include "flex_layout.h"
+#include "widget/object.h"
+
+#include <cmath>
+
+
+
+namespace maple
+{
+
+namespace
+{
+
+constexpr std::uint32_t none = WidgetStorage::none;
+constexpr std::uint8_t pending_flags = WidgetStorage::layout_dirty | WidgetStorage::layout_descendant_dirty;
+constexpr std::uint8_t change_flags = WidgetStorage::flag_moved | WidgetStorage::flag_changed
+                                    | WidgetStorage::flag_descendant_changed;
+
+// subtrees with fewer rows are laid out on the thread that placed them
+constexpr std::uint32_t fork_row_count = 256;
+
+int shrink_bound(int length_, int amount_)
+{
+    if (length_ == LayoutConstraints::unbounded)
+        return length_;
+    return std::max(length_ - amount_, 0);
+}
+
+}
+
+
+
+// ====================================================================================================================
+//     CLASS: FlexLayout
+// ====================================================================================================================
+
+//
+// Marks for update stop at the boundary, none for a pass over a whole tree.
+//
+FlexLayout::FlexLayout(WidgetStorage& storage_, JobSystem* job_system_, std::uint32_t boundary_)
+    : m_storage{ storage_ },
+      m_job_system{ job_system_ },
+      m_boundary{ boundary_ },
+      m_arranged_rows{ 0 },
+      m_measured_rows{ 0 }
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Lays out the subtree of a row whose own rect is not set by this pass.
+//
+void FlexLayout::run(std::uint32_t row_)
+{
+    p_layout(row_, false);
+}
+
+std::size_t FlexLayout::get_arranged_rows() const
+{
+    return m_arranged_rows;
+}
+
+std::size_t FlexLayout::get_measured_rows() const
+{
+    return m_measured_rows;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void FlexLayout::p_layout(std::uint32_t row_, bool is_resized_)
+{
+    auto& storage = m_storage;
+    std::uint8_t flags = storage.m_layout_flags[row_];
+    if (!is_resized_ && !(flags & pending_flags))
+        return;
+
+    storage.m_layout_flags[row_] = flags & ~pending_flags;
+    if (storage.p_is_flex_container(row_) && (is_resized_ || (flags & WidgetStorage::layout_dirty)))
+    {
+        p_arrange(row_);
+        return;
+    }
+
+    std::size_t first = m_items.size();
+    for (std::uint32_t child = storage.m_first_children[row_]; child != none; child = storage.m_next_siblings[child])
+        m_items.push_back(Item{ .row = child, .basis = 0.0f, .size = 0.0f, .cross_size = 0,
+                                .is_resized = false, .is_forked = false });
+    p_layout_items(first);
+}
+
+//
+// Places the children of a flex container within its rect, then lays out the children that need it.
+//
+void FlexLayout::p_arrange(std::uint32_t row_)
+{
+    auto& storage = m_storage;
+    m_arranged_rows++;
+
+    const LayoutStyle style = storage.m_layout_styles[row_];
+    const Rect& rect = storage.m_rects[row_];
+    bool is_row = style.direction == FlexDirection::row;
+    int main_length = std::max((is_row ? rect.width : rect.height) - 2 * style.padding, 0);
+    int cross_length = std::max((is_row ? rect.height : rect.width) - 2 * style.padding, 0);
+    LayoutConstraints constraints = is_row ? LayoutConstraints{ .max_height = cross_length }
+                                           : LayoutConstraints{ .max_width = cross_length };
+
+    std::size_t first = m_items.size();
+    float total_basis = 0.0f;
+    float total_grow = 0.0f;
+    float total_shrink = 0.0f;
+    for (std::uint32_t child = storage.m_first_children[row_]; child != none; child = storage.m_next_siblings[child])
+    {
+        Size size = p_measure(child, constraints);
+        float basis = static_cast<float>(is_row ? size.width : size.height);
+        m_items.push_back(Item{ .row = child, .basis = basis, .size = basis,
+                                .cross_size = is_row ? size.height : size.width,
+                                .is_resized = false, .is_forked = false });
+
+        const LayoutStyle& child_style = storage.m_layout_styles[child];
+        total_basis += basis;
+        total_grow += child_style.grow;
+        total_shrink += child_style.shrink * basis;
+    }
+
+    std::size_t count = m_items.size() - first;
+    if (count == 0)
+        return;
+
+    float gaps = static_cast<float>(style.gap) * static_cast<float>(count - 1);
+    float free = static_cast<float>(main_length) - total_basis - gaps;
+    if (free > 0.0f && total_grow > 0.0f)
+    {
+        for (std::size_t i = first; i < m_items.size(); i++)
+            m_items[i].size += free * storage.m_layout_styles[m_items[i].row].grow / total_grow;
+        free = 0.0f;
+    }
+    else if (free < 0.0f && total_shrink > 0.0f)
+    {
+        for (std::size_t i = first; i < m_items.size(); i++)
+        {
+            auto& item = m_items[i];
+            float share = storage.m_layout_styles[item.row].shrink * item.basis / total_shrink;
+            item.size = std::max(item.size + free * share, 0.0f);
+        }
+        free = 0.0f;
+    }
+
+    float position = static_cast<float>(style.padding);
+    float spacing = static_cast<float>(style.gap);
+    float leftover = std::max(free, 0.0f);
+    switch (style.justify)
+    {
+    case FlexJustify::start:            break;
+    case FlexJustify::center:           position += leftover / 2.0f; break;
+    case FlexJustify::end:              position += leftover; break;
+    case FlexJustify::space_between:    spacing += count > 1 ? leftover / static_cast<float>(count - 1) : 0.0f; break;
+    }
+
+    for (std::size_t i = first; i < m_items.size(); i++)
+    {
+        auto& item = m_items[i];
+        const LayoutStyle& child_style = storage.m_layout_styles[item.row];
+        int main_start = static_cast<int>(std::lround(position));
+        int main_end = static_cast<int>(std::lround(position + item.size));
+        position += item.size + spacing;
+
+        bool is_cross_fixed = (is_row ? child_style.height : child_style.width) != LayoutStyle::auto_size;
+        int cross_size = std::min(item.cross_size, cross_length);
+        if (is_cross_fixed)
+            cross_size = item.cross_size;
+        else if (style.align == FlexAlign::stretch)
+            cross_size = cross_length;
+
+        int cross_start = style.padding;
+        if (style.align == FlexAlign::center)
+            cross_start += (cross_length - cross_size) / 2;
+        else if (style.align == FlexAlign::end)
+            cross_start += cross_length - cross_size;
+
+        Rect child_rect = is_row ? Rect{ .x = main_start, .y = cross_start,
+                                         .width = main_end - main_start, .height = cross_size }
+                                 : Rect{ .x = cross_start, .y = main_start,
+                                         .width = cross_size, .height = main_end - main_start };
+        item.is_resized = storage.p_set_layout_rect(item.row, child_rect, m_boundary);
+    }
+
+    p_layout_items(first);
+}
+
+//
+// Lays out the subtrees of the items from first_ on, which were placed already, and drops the items.
+//
+void FlexLayout::p_layout_items(std::size_t first_)
+{
+    auto& storage = m_storage;
+    std::size_t last = m_items.size();
+
+    std::vector<Fork> forks;
+    if (m_job_system)
+        for (std::size_t i = first_; i < last; i++)
+        {
+            auto& item = m_items[i];
+            bool is_pending = item.is_resized || (storage.m_layout_flags[item.row] & pending_flags);
+            if (!is_pending || storage.m_subtree_sizes[item.row] < fork_row_count)
+                continue;
+
+            item.is_forked = true;
+            forks.push_back(Fork{ .row = item.row, .is_resized = item.is_resized,
+                                  .arranged_rows = 0, .measured_rows = 0 });
+        }
+
+    JobSystem::JobGroup group;
+    for (auto& fork : forks)
+        m_job_system->run(group, [&storage, job_system = m_job_system, &fork]()
+            {
+                FlexLayout flex_layout(storage, job_system, fork.row);
+                flex_layout.p_layout(fork.row, fork.is_resized);
+                fork.arranged_rows = flex_layout.m_arranged_rows;
+                fork.measured_rows = flex_layout.m_measured_rows;
+            });
+
+    // the items vector grows and shrinks again below, so items are only accessed by index
+    try
+    {
+        for (std::size_t i = first_; i < last; i++)
+            if (!m_items[i].is_forked)
+                p_layout(m_items[i].row, m_items[i].is_resized);
+    }
+    catch (...)
+    {
+        if (!forks.empty())
+            m_job_system->wait(group);
+        throw;
+    }
+
+    if (!forks.empty())
+        m_job_system->wait(group);
+    for (auto& fork : forks)
+    {
+        m_arranged_rows += fork.arranged_rows;
+        m_measured_rows += fork.measured_rows;
+        if (storage.m_flags[fork.row] & change_flags)
+            storage.p_mark(fork.row, 0, m_boundary);
+    }
+
+    m_items.resize(first_);
+}
+
+//
+// The size a row takes under the constraints: its fixed width and height, and the size of its content for the rest.
+// A flex container measures its children, a widget with a custom measure asks its Object, anything else is empty.
+//
+Size FlexLayout::p_measure(std::uint32_t row_, const LayoutConstraints& constraints_)
+{
+    auto& storage = m_storage;
+    auto& cache = storage.m_measure_caches[row_];
+    if (const Size* size = cache.find(constraints_))
+        return *size;
+    m_measured_rows++;
+
+    const LayoutStyle& style = storage.m_layout_styles[row_];
+    bool is_width_fixed = style.width != LayoutStyle::auto_size;
+    bool is_height_fixed = style.height != LayoutStyle::auto_size;
+    LayoutConstraints constraints{ .max_width = is_width_fixed ? style.width : constraints_.max_width,
+                                   .max_height = is_height_fixed ? style.height : constraints_.max_height };
+
+    Size size{};
+    bool is_fixed = is_width_fixed && is_height_fixed;
+    if (!is_fixed && storage.p_is_flex_container(row_))
+        size = p_measure_children(row_, constraints);
+    else if (!is_fixed && (storage.m_layout_flags[row_] & WidgetStorage::layout_custom_measure))
+        size = storage.m_objects[row_]->measure(constraints);
+
+    if (is_width_fixed)
+        size.width = style.width;
+    if (is_height_fixed)
+        size.height = style.height;
+
+    cache.add(constraints_, size);
+    return size;
+}
+
+//
+// The children of a flex container side by side along its main axis, with its gaps and padding.
+//
+Size FlexLayout::p_measure_children(std::uint32_t row_, const LayoutConstraints& constraints_)
+{
+    auto& storage = m_storage;
+    const LayoutStyle& style = storage.m_layout_styles[row_];
+    bool is_row = style.direction == FlexDirection::row;
+    LayoutConstraints constraints = is_row
+        ? LayoutConstraints{ .max_height = shrink_bound(constraints_.max_height, 2 * style.padding) }
+        : LayoutConstraints{ .max_width = shrink_bound(constraints_.max_width, 2 * style.padding) };
+
+    int main_size = 0;
+    int cross_size = 0;
+    int count = 0;
+    for (std::uint32_t child = storage.m_first_children[row_]; child != none; child = storage.m_next_siblings[child])
+    {
+        Size child_size = p_measure(child, constraints);
+        main_size += is_row ? child_size.width : child_size.height;
+        cross_size = std::max(cross_size, is_row ? child_size.height : child_size.width);
+        count++;
+    }
+    if (count > 1)
+        main_size += style.gap * (count - 1);
+
+    main_size += 2 * style.padding;
+    cross_size += 2 * style.padding;
+    return is_row ? Size{ .width = main_size, .height = cross_size } : Size{ .width = cross_size, .height = main_size };
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "define.h"
+#include "widget/widget_storage.h"
+#include "job_system.h"
+
+namespace maple
+{
+
+// ====================================================================================================================
+//      INTERNAL CLASS: FlexLayout
+// ====================================================================================================================
+
+//
+// One layout pass over the rows of a WidgetStorage, walking the rows marked by WidgetStorage::p_invalidate_layout.
+// A flex container is arranged when it was invalidated or its size changed. Arranging measures every child,
+// which mostly hits the measure caches, places them, and goes on into the children whose size changed
+// or that lead to an invalidated row. Everything else is skipped.
+// Sizes are computed in floats and every edge is rounded on its own, so neighbours never overlap or leave gaps.
+// Once a container placed its children, the subtree of each child only reads and writes its own rows.
+// With a job system, children with large subtrees are then laid out by FlexLayouts of their own on its workers,
+// bounded to their subtree, and the marks for update are carried above the subtree after joining.
+// Every subtree is computed the same way on whichever thread, so the result does not depend on the workers.
+//
+class FlexLayout
+{
+public:
+    FlexLayout(WidgetStorage& storage_, JobSystem* job_system_, std::uint32_t boundary_);
+
+    void run(std::uint32_t row_);
+
+    std::size_t get_arranged_rows() const;
+    std::size_t get_measured_rows() const;
+
+private:
+    struct Item
+    {
+        std::uint32_t row;
+        float basis;
+        float size;
+        int cross_size;
+        bool is_resized;
+        bool is_forked;
+    };
+
+    struct Fork
+    {
+        std::uint32_t row;
+        bool is_resized;
+        std::size_t arranged_rows;
+        std::size_t measured_rows;
+    };
+
+    void p_layout(std::uint32_t row_, bool is_resized_);
+    void p_arrange(std::uint32_t row_);
+    void p_layout_items(std::size_t first_);
+    Size p_measure(std::uint32_t row_, const LayoutConstraints& constraints_);
+    Size p_measure_children(std::uint32_t row_, const LayoutConstraints& constraints_);
+
+    WidgetStorage& m_storage;
+    JobSystem* m_job_system;
+    std::uint32_t m_boundary;
+
+    // the children of every container being arranged, innermost last
+    std::vector<Item> m_items;
+
+    std::size_t m_arranged_rows;
+    std::size_t m_measured_rows;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,296 @@
+#include "widget/object.h"
+
+#include "painter.h"
+#include "damage_region.h"
+
+
+
+namespace maple
+{
+
+
+
+// ====================================================================================================================
+//     CLASS: Object
+// ====================================================================================================================
+
+//
+// A widget starts in the storage of the parent it is created for, so adding it to that parent moves nothing.
+//
+Object::Object(std::shared_ptr<Object> parent_)
+    : m_storage{ parent_ ? parent_->m_storage : WidgetStorage::create() },
+      m_parent{ nullptr }
+{
+    m_handle = m_storage->allocate(this);
+}
+
+Object::~Object()
+{
+    for (auto& child : m_children)
+        child->m_parent = nullptr;
+    m_storage->release(m_handle);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void Object::set_custom_render(bool is_custom_)
+{
+    m_storage->set_custom_render(m_handle, is_custom_);
+}
+
+void Object::set_custom_measure(bool is_custom_)
+{
+    m_storage->set_custom_measure(m_handle, is_custom_);
+}
+
+WidgetStorage& Object::get_storage() const
+{
+    return *m_storage;
+}
+
+const WidgetHandle& Object::get_handle() const
+{
+    return m_handle;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void Object::set_rect(const Rect& rect_)
+{
+    m_storage->set_rect(m_handle, rect_);
+}
+
+const Rect& Object::get_rect() const
+{
+    return m_storage->get_rect(m_handle);
+}
+
+//
+// The rect in window coordinates as of the last update.
+//
+const Rect& Object::get_world_rect() const
+{
+    return m_storage->get_world_rect(m_handle);
+}
+
+//
+// The size of the content of a widget with a custom measure. The constraints are the most it may take,
+// and are unbounded along the main axis of its parent. Only called again after invalidate_layout,
+// or under constraints it was not measured under yet.
+//
+Size Object::measure([[maybe_unused]] const LayoutConstraints& constraints_)
+{
+    return Size{};
+}
+
+void Object::set_layout_style(const LayoutStyle& style_)
+{
+    m_storage->set_layout_style(m_handle, style_);
+}
+
+const LayoutStyle& Object::get_layout_style() const
+{
+    return m_storage->get_layout_style(m_handle);
+}
+
+//
+// Redraws the widget on the next frame, for widgets whose content changed without moving.
+//
+void Object::invalidate()
+{
+    m_storage->mark(m_handle, WidgetStorage::flag_changed);
+}
+
+//
+// Measures the widget again on the next frame, for widgets whose content changed size.
+//
+void Object::invalidate_layout()
+{
+    m_storage->invalidate_layout(m_handle);
+}
+
+//
+// Moves the child from its current parent, if any, to the end of the children of this widget.
+//
+void Object::add_child(std::shared_ptr<Object> child_)
+{
+    if (!parentable())
+        throw std::runtime_error("void Object::add_child(std::shared_ptr<Object>): The widget cannot have children.");
+
+    for (Object* ancestor = this; ancestor; ancestor = ancestor->m_parent)
+        if (ancestor == child_.get())
+            throw std::runtime_error("void Object::add_child(std::shared_ptr<Object>): "
+                                     "A widget cannot be added to itself or its descendants.");
+
+    child_->remove();
+    if (child_->m_storage != m_storage)
+        child_->p_move_to(m_storage);
+
+    child_->m_parent = this;
+    m_storage->attach(m_handle, child_->m_handle);
+    m_children.push_back(std::move(child_));
+}
+
+//
+// Detaches the widget from its parent. The parent is redrawn where the widget was.
+//
+void Object::remove()
+{
+    if (!m_parent)
+        return;
+
+    Object* parent = std::exchange(m_parent, nullptr);
+    m_storage->detach(m_handle);
+    std::erase(parent->m_children, shared_from_this());
+}
+
+Object* Object::get_parent() const
+{
+    return m_parent;
+}
+
+const std::vector<std::shared_ptr<Object>>& Object::get_children() const
+{
+    return m_children;
+}
+
+bool Object::has_changes() const
+{
+    return m_storage->has_changes(m_handle);
+}
+
+//
+// Grows with every change to the tree the widget belongs to, see WidgetStorage::get_change_count.
+//
+std::uint64_t Object::get_change_count() const
+{
+    return m_storage->get_change_count();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Lays out the flex containers of the subtree that were invalidated or resized. Called on the root by its Window
+// right before update, with the job system of its Context.
+//
+void Object::layout(JobSystem* job_system_)
+{
+    m_storage->layout(m_handle, job_system_);
+}
+
+//
+// Called on the root by its Window before every frame is recorded. Recomputes the world rects of moved subtrees
+// and adds the old and new rects of everything that changed to the damage.
+//
+void Object::update(DamageRegion& damage_)
+{
+    m_storage->update(m_handle, damage_);
+}
+
+//
+// Renders this widget and its descendants that intersect the damage.
+//
+void Object::draw(Painter& painter_, const DamageRegion& damage_)
+{
+    m_storage->draw(m_handle, painter_, damage_);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Copies the rows of a detached subtree into another storage, for widgets moving between trees.
+//
+void Object::p_move_to(const std::shared_ptr<WidgetStorage>& storage_)
+{
+    auto& source = *m_storage;
+    WidgetHandle handle = storage_->allocate(this);
+    storage_->set_rect(handle, source.get_rect(m_handle));
+    storage_->set_draw_data(handle, source.get_draw_data(m_handle));
+    storage_->set_custom_render(handle, source.get_custom_render(m_handle));
+    storage_->set_layout_style(handle, source.get_layout_style(m_handle));
+    storage_->set_custom_measure(handle, source.get_custom_measure(m_handle));
+    source.release(m_handle);
+
+    m_storage = storage_;
+    m_handle = handle;
+    for (auto& child : m_children)
+    {
+        child->p_move_to(storage_);
+        storage_->attach(m_handle, child->m_handle);
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+
+
+// ====================================================================================================================
+//     CLASS: Frame
+// ====================================================================================================================
+
+std::shared_ptr<Frame> Frame::create(std::shared_ptr<Object> parent_)
+{
+    struct MakeSharedEnabler : public Frame
+    {
+        MakeSharedEnabler(std::shared_ptr<Object> parent_)
+            : Frame(parent_) {}
+    };
+    auto frame = std::make_shared<MakeSharedEnabler>(parent_);
+    if (parent_)
+        parent_->add_child(frame);
+    return frame;
+}
+
+std::shared_ptr<Frame> Frame::create(std::shared_ptr<Object> parent_, const Rect& rect_, const Color& color_)
+{
+    auto frame = create(parent_);
+    frame->set_rect(rect_);
+    frame->set_color(color_);
+    return frame;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+Frame::Frame(std::shared_ptr<Object> parent_)
+    : Object(parent_)
+{
+}
+
+Frame::~Frame()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Frames are drawn from their draw data by the storage, this is only called when a subclass enables a custom render.
+//
+void Frame::render(Painter& painter_)
+{
+    auto& draw_data = get_storage().get_draw_data(get_handle());
+    if (draw_data.color.a > 0.0f)
+        painter_.fill_rect(get_world_rect(), draw_data.color, draw_data.corner_radius);
+}
+
+void Frame::set_color(const Color& color_)
+{
+    auto draw_data = get_storage().get_draw_data(get_handle());
+    draw_data.color = color_;
+    get_storage().set_draw_data(get_handle(), draw_data);
+}
+
+const Color& Frame::get_color() const
+{
+    return get_storage().get_draw_data(get_handle()).color;
+}
+
+void Frame::set_corner_radius(float corner_radius_)
+{
+    auto draw_data = get_storage().get_draw_data(get_handle());
+    draw_data.corner_radius = corner_radius_;
+    get_storage().set_draw_data(get_handle(), draw_data);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,675 @@
+#include "widget/widget_storage.h"
+#include "widget/object.h"
+#include "flex_layout.h"
+
+#include "painter.h"
+#include "damage_region.h"
+
+
+
+namespace maple
+{
+
+namespace
+{
+
+bool is_same_rect(const Rect& a_, const Rect& b_)
+{
+    return a_.x == b_.x && a_.y == b_.y && a_.width == b_.width && a_.height == b_.height;
+}
+
+bool is_same_size(const Rect& a_, const Rect& b_)
+{
+    return a_.width == b_.width && a_.height == b_.height;
+}
+
+//
+// Reorders a table so that row i receives the old row order_[i].
+//
+template <typename T>
+void permute(std::vector<T>& table_, const std::vector<std::uint32_t>& order_)
+{
+    std::vector<T> sorted;
+    sorted.reserve(order_.size());
+    for (std::uint32_t row : order_)
+        sorted.push_back(table_[row]);
+    table_ = std::move(sorted);
+}
+
+constexpr std::uint8_t change_flags = WidgetStorage::flag_moved | WidgetStorage::flag_changed
+                                    | WidgetStorage::flag_descendant_changed;
+
+}
+
+
+
+// ====================================================================================================================
+//     CLASS: WidgetStorage
+// ====================================================================================================================
+
+const Size* WidgetStorage::MeasureCache::find(const LayoutConstraints& constraints_) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        if (entries[i].constraints.max_width == constraints_.max_width
+            && entries[i].constraints.max_height == constraints_.max_height)
+            return &entries[i].size;
+    return nullptr;
+}
+
+//
+// Replaces the oldest entry once the cache is full.
+//
+void WidgetStorage::MeasureCache::add(const LayoutConstraints& constraints_, const Size& size_)
+{
+    entries[next] = Entry{ .constraints = constraints_, .size = size_ };
+    next = static_cast<std::uint8_t>((next + 1) % capacity);
+    count = static_cast<std::uint8_t>(std::min<std::size_t>(count + 1, capacity));
+}
+
+void WidgetStorage::MeasureCache::clear()
+{
+    count = 0;
+    next = 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<WidgetStorage> WidgetStorage::create()
+{
+    struct MakeSharedEnabler : public WidgetStorage {};
+    return std::make_shared<MakeSharedEnabler>();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+WidgetStorage::WidgetStorage()
+    : m_dead_rows{ 0 },
+      m_change_count{ 0 },
+      m_is_sorted{ true },
+      m_statistics{}
+{
+}
+
+WidgetStorage::~WidgetStorage()
+{
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Adds a root at the end of the tables. object_ is called to render the widget when it has a custom render.
+//
+WidgetHandle WidgetStorage::allocate(Object* object_)
+{
+    std::uint32_t slot = 0;
+    if (!m_free_slots.empty())
+    {
+        slot = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<std::uint32_t>(m_rows.size());
+        m_rows.push_back(none);
+        m_generations.push_back(0);
+    }
+
+    std::uint32_t row = static_cast<std::uint32_t>(m_flags.size());
+    p_append_row();
+    m_flags[row] = flag_alive | flag_moved;
+    m_objects[row] = object_;
+    m_slots[row] = slot;
+    m_rows[slot] = row;
+
+    return WidgetHandle{ .index = slot, .generation = m_generations[slot] };
+}
+
+//
+// The children of the widget become roots. Its row is only reclaimed by the next sort.
+//
+void WidgetStorage::release(const WidgetHandle& handle_)
+{
+    std::uint32_t row = p_get_row(handle_);
+    if (m_parents[row] != none)
+    {
+        if (p_is_flex_container(m_parents[row]))
+            p_invalidate_layout(m_parents[row]);
+        p_unlink(row);
+    }
+
+    for (std::uint32_t child = m_first_children[row]; child != none;)
+    {
+        m_parents[child] = none;
+        child = std::exchange(m_next_siblings[child], none);
+    }
+
+    m_first_children[row] = none;
+    m_last_children[row] = none;
+    m_flags[row] = 0;
+    m_layout_flags[row] = 0;
+    m_objects[row] = nullptr;
+
+    m_rows[handle_.index] = none;
+    m_generations[handle_.index]++;
+    m_free_slots.push_back(handle_.index);
+
+    m_dead_rows++;
+    m_is_sorted = false;
+    m_change_count++;
+}
+
+bool WidgetStorage::contains(const WidgetHandle& handle_) const
+{
+    return handle_.index < m_rows.size() && m_generations[handle_.index] == handle_.generation
+                                         && m_rows[handle_.index] != none;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Appends the child, which must be a root, to the children of the parent.
+// The tables stay sorted when the child is the last subtree and the parent's subtree ends right before it.
+//
+void WidgetStorage::attach(const WidgetHandle& parent_, const WidgetHandle& child_)
+{
+    std::uint32_t parent = p_get_row(parent_);
+    std::uint32_t child = p_get_row(child_);
+    if (m_parents[child] != none)
+        throw std::runtime_error("void WidgetStorage::attach(const WidgetHandle&, const WidgetHandle&): "
+                                 "The child already has a parent.");
+
+    bool is_order_kept = m_is_sorted && child + m_subtree_sizes[child] == m_flags.size()
+                                     && parent + m_subtree_sizes[parent] == child;
+
+    m_parents[child] = parent;
+    m_next_siblings[child] = none;
+    if (m_last_children[parent] == none)
+        m_first_children[parent] = child;
+    else
+        m_next_siblings[m_last_children[parent]] = child;
+    m_last_children[parent] = child;
+
+    if (is_order_kept)
+        for (std::uint32_t ancestor = parent; ancestor != none; ancestor = m_parents[ancestor])
+            m_subtree_sizes[ancestor] += m_subtree_sizes[child];
+    else
+        m_is_sorted = false;
+
+    mark(child_, flag_moved);
+    p_invalidate_layout(child);
+    if (p_is_flex_container(parent))
+        p_invalidate_layout(parent);
+}
+
+//
+// Makes the widget a root. Its former parent is redrawn where the widget was.
+//
+void WidgetStorage::detach(const WidgetHandle& handle_)
+{
+    std::uint32_t row = p_get_row(handle_);
+    std::uint32_t parent = m_parents[row];
+    if (parent == none)
+        return;
+
+    p_unlink(row);
+    p_mark(parent, flag_changed);
+    if (p_is_flex_container(parent))
+        p_invalidate_layout(parent);
+    m_change_count++;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// The rects of the children of a flex container are set by the layout, and any other rect is overwritten.
+// Resizing a flex container lays out its children again.
+//
+void WidgetStorage::set_rect(const WidgetHandle& handle_, const Rect& rect_)
+{
+    std::uint32_t row = p_get_row(handle_);
+    if (is_same_rect(m_rects[row], rect_))
+        return;
+
+    if (!is_same_size(m_rects[row], rect_) && p_is_flex_container(row))
+        p_mark_layout(row);
+    m_rects[row] = rect_;
+    mark(handle_, flag_moved);
+}
+
+const Rect& WidgetStorage::get_rect(const WidgetHandle& handle_) const
+{
+    return m_rects[p_get_row(handle_)];
+}
+
+//
+// The rect in the coordinates of the root as of the last update.
+//
+const Rect& WidgetStorage::get_world_rect(const WidgetHandle& handle_) const
+{
+    return m_world_rects[p_get_row(handle_)];
+}
+
+void WidgetStorage::set_draw_data(const WidgetHandle& handle_, const DrawData& draw_data_)
+{
+    m_draw_data[p_get_row(handle_)] = draw_data_;
+    mark(handle_, flag_changed);
+}
+
+const WidgetStorage::DrawData& WidgetStorage::get_draw_data(const WidgetHandle& handle_) const
+{
+    return m_draw_data[p_get_row(handle_)];
+}
+
+//
+// Widgets with a custom render are drawn by Object::render instead of from their draw data.
+//
+void WidgetStorage::set_custom_render(const WidgetHandle& handle_, bool is_custom_)
+{
+    std::uint32_t row = p_get_row(handle_);
+    if (is_custom_)
+        m_flags[row] |= flag_custom_render;
+    else
+        m_flags[row] &= ~flag_custom_render;
+    mark(handle_, flag_changed);
+}
+
+bool WidgetStorage::get_custom_render(const WidgetHandle& handle_) const
+{
+    return m_flags[p_get_row(handle_)] & flag_custom_render;
+}
+
+//
+// The parent is laid out again as well, since the style also says how the widget is laid out within it.
+//
+void WidgetStorage::set_layout_style(const WidgetHandle& handle_, const LayoutStyle& style_)
+{
+    std::uint32_t row = p_get_row(handle_);
+    m_layout_styles[row] = style_;
+    p_invalidate_layout(row);
+    if (m_parents[row] != none && p_is_flex_container(m_parents[row]))
+        p_invalidate_layout(m_parents[row]);
+}
+
+const LayoutStyle& WidgetStorage::get_layout_style(const WidgetHandle& handle_) const
+{
+    return m_layout_styles[p_get_row(handle_)];
+}
+
+//
+// Widgets with a custom measure are measured by Object::measure, the others take the size of their children.
+//
+void WidgetStorage::set_custom_measure(const WidgetHandle& handle_, bool is_custom_)
+{
+    std::uint32_t row = p_get_row(handle_);
+    if (is_custom_)
+        m_layout_flags[row] |= layout_custom_measure;
+    else
+        m_layout_flags[row] &= ~layout_custom_measure;
+    p_invalidate_layout(row);
+}
+
+bool WidgetStorage::get_custom_measure(const WidgetHandle& handle_) const
+{
+    return m_layout_flags[p_get_row(handle_)] & layout_custom_measure;
+}
+
+//
+// Called when the size a widget measures changed, such as a label whose text changed.
+//
+void WidgetStorage::invalidate_layout(const WidgetHandle& handle_)
+{
+    p_invalidate_layout(p_get_row(handle_));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Sets flags on the widget, and marks every ancestor as leading to a change,
+// stopping at the first ancestor that was already marked.
+//
+void WidgetStorage::mark(const WidgetHandle& handle_, std::uint8_t flags_)
+{
+    p_mark(p_get_row(handle_), flags_);
+    m_change_count++;
+}
+
+bool WidgetStorage::has_changes(const WidgetHandle& handle_) const
+{
+    std::uint32_t row = p_get_row(handle_);
+    return (m_flags[row] & change_flags) || (m_layout_flags[row] & (layout_dirty | layout_descendant_dirty));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Rewrites every table in depth-first order, roots in the order of their rows, and drops released rows.
+//
+void WidgetStorage::sort()
+{
+    if (m_is_sorted)
+        return;
+
+    std::uint32_t row_count = static_cast<std::uint32_t>(m_flags.size());
+    std::vector<std::uint32_t> order;
+    order.reserve(row_count - m_dead_rows);
+
+    for (std::uint32_t root = 0; root < row_count; root++)
+    {
+        if (!(m_flags[root] & flag_alive) || m_parents[root] != none)
+            continue;
+
+        // preorder without a stack: descend to the first child, or climb until there is a next sibling
+        std::uint32_t row = root;
+        while (true)
+        {
+            order.push_back(row);
+            if (m_first_children[row] != none)
+            {
+                row = m_first_children[row];
+                continue;
+            }
+            while (row != root && m_next_siblings[row] == none)
+                row = m_parents[row];
+            if (row == root)
+                break;
+            row = m_next_siblings[row];
+        }
+    }
+
+    std::vector<std::uint32_t> new_rows(row_count, none);
+    for (std::uint32_t i = 0; i < order.size(); i++)
+        new_rows[order[i]] = i;
+
+    auto remap = [&new_rows](std::vector<std::uint32_t>& table_)
+        {
+            for (auto& row : table_)
+                if (row != none)
+                    row = new_rows[row];
+        };
+
+    permute(m_rects, order);
+    permute(m_world_rects, order);
+    permute(m_flags, order);
+    permute(m_parents, order);
+    permute(m_first_children, order);
+    permute(m_last_children, order);
+    permute(m_next_siblings, order);
+    permute(m_draw_data, order);
+    permute(m_layout_styles, order);
+    permute(m_layout_flags, order);
+    permute(m_measure_caches, order);
+    permute(m_objects, order);
+    permute(m_slots, order);
+    remap(m_parents);
+    remap(m_first_children);
+    remap(m_last_children);
+    remap(m_next_siblings);
+
+    // children follow their parent, so summing backwards completes every subtree before its parent
+    m_subtree_sizes.assign(order.size(), 1);
+    for (std::size_t i = order.size(); i-- > 0;)
+        if (m_parents[i] != none)
+            m_subtree_sizes[m_parents[i]] += m_subtree_sizes[i];
+
+    for (std::uint32_t i = 0; i < order.size(); i++)
+        m_rows[m_slots[i]] = i;
+
+    m_dead_rows = 0;
+    m_is_sorted = true;
+    m_statistics.sorts++;
+}
+
+//
+// Lays out the flex containers of the subtree that were invalidated or resized, and the containers within them
+// whose size changed as a result. Runs before update, which picks up the rects the layout changed.
+// With a job system, large subtrees are laid out on its workers, with the same result.
+//
+void WidgetStorage::layout(const WidgetHandle& root_, JobSystem* job_system_)
+{
+    // forking looks at subtree sizes, which are only kept while sorted
+    sort();
+
+    FlexLayout flex_layout(*this, job_system_, none);
+    flex_layout.run(p_get_row(root_));
+    m_statistics.arranged_rows = flex_layout.get_arranged_rows();
+    m_statistics.measured_rows = flex_layout.get_measured_rows();
+}
+
+//
+// Recomputes the world rects of moved subtrees and adds the old and new rects of everything that changed
+// to the damage, visiting only the rows on the way to a change. Rows read the flags their parent left
+// during the same update, which tell whether the parent moved and whether it already damaged an area
+// that covers its children.
+//
+void WidgetStorage::update(const WidgetHandle& root_, DamageRegion& damage_)
+{
+    sort();
+    m_statistics.updated_rows = 0;
+
+    std::uint32_t root = p_get_row(root_);
+    std::uint32_t end = root + m_subtree_sizes[root];
+    for (std::uint32_t row = root; row < end;)
+    {
+        std::uint8_t flags = m_flags[row];
+        std::uint32_t parent = row == root ? none : m_parents[row];
+        bool is_parent_moved = parent != none && (m_flags[parent] & flag_moved_in_update);
+        if (!is_parent_moved && !(flags & change_flags))
+        {
+            row += m_subtree_sizes[row];
+            continue;
+        }
+        m_statistics.updated_rows++;
+
+        bool is_moved = is_parent_moved || (flags & flag_moved);
+        bool is_damaged = parent != none && (m_flags[parent] & flag_damaged_in_update);
+        if (is_moved)
+        {
+            const Rect& rect = m_rects[row];
+            Point origin{};
+            if (parent != none)
+                origin = Point{ .x = m_world_rects[parent].x, .y = m_world_rects[parent].y };
+            Rect world{ .x = origin.x + rect.x, .y = origin.y + rect.y, .width = rect.width, .height = rect.height };
+            if (!is_damaged && !is_same_rect(world, m_world_rects[row]))
+            {
+                damage_.add(m_world_rects[row]);
+                damage_.add(world);
+                is_damaged = true;
+            }
+            m_world_rects[row] = world;
+        }
+
+        if (!is_damaged && (flags & flag_changed))
+        {
+            damage_.add(m_world_rects[row]);
+            is_damaged = true;
+        }
+
+        m_flags[row] = (flags & (flag_alive | flag_custom_render)) | (is_moved ? flag_moved_in_update : 0)
+                                                                 | (is_damaged ? flag_damaged_in_update : 0);
+        row += is_moved || (flags & flag_descendant_changed) ? 1 : m_subtree_sizes[row];
+    }
+}
+
+//
+// Draws every row of the subtree that intersects the damage, in depth-first order.
+//
+void WidgetStorage::draw(const WidgetHandle& root_, Painter& painter_, const DamageRegion& damage_)
+{
+    sort();
+    m_statistics.drawn_rows = 0;
+
+    std::uint32_t root = p_get_row(root_);
+    std::uint32_t end = root + m_subtree_sizes[root];
+    for (std::uint32_t row = root; row < end;)
+    {
+        if (!damage_.intersects(m_world_rects[row]))
+        {
+            row += m_subtree_sizes[row];
+            continue;
+        }
+        m_statistics.drawn_rows++;
+
+        if (m_flags[row] & flag_custom_render)
+            m_objects[row]->render(painter_);
+        else if (m_draw_data[row].color.a > 0.0f)
+            painter_.fill_rect(m_world_rects[row], m_draw_data[row].color, m_draw_data[row].corner_radius);
+        row++;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Rows including released rows that were not sorted out yet.
+//
+std::size_t WidgetStorage::get_size() const
+{
+    return m_flags.size();
+}
+
+//
+// Grows with every change made through the public functions, but not by layout or update,
+// so comparing it before and after a callback tells whether the callback changed any widget.
+//
+std::uint64_t WidgetStorage::get_change_count() const
+{
+    return m_change_count;
+}
+
+//
+// updated_rows and drawn_rows count the rows visited by the last update and draw, arranged_rows the flex containers
+// that placed their children in the last layout, and measured_rows the measures it did not find in a cache.
+//
+const WidgetStorage::Statistics& WidgetStorage::get_statistics() const
+{
+    return m_statistics;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+std::uint32_t WidgetStorage::p_get_row(const WidgetHandle& handle_) const
+{
+    if (!contains(handle_))
+        throw std::runtime_error("std::uint32_t WidgetStorage::p_get_row(const WidgetHandle&): "
+                                 "The widget was released.");
+
+    return m_rows[handle_.index];
+}
+
+void WidgetStorage::p_append_row()
+{
+    m_rects.push_back(Rect{});
+    m_world_rects.push_back(Rect{});
+    m_flags.push_back(0);
+    m_parents.push_back(none);
+    m_first_children.push_back(none);
+    m_last_children.push_back(none);
+    m_next_siblings.push_back(none);
+    m_subtree_sizes.push_back(1);
+    m_draw_data.push_back(DrawData{});
+    m_layout_styles.push_back(LayoutStyle{});
+    m_layout_flags.push_back(0);
+    m_measure_caches.push_back(MeasureCache{});
+    m_objects.push_back(nullptr);
+    m_slots.push_back(none);
+}
+
+//
+// Stops after marking the boundary, for layout tasks that must not touch rows outside of their subtree.
+//
+void WidgetStorage::p_mark(std::uint32_t row_, std::uint8_t flags_, std::uint32_t boundary_)
+{
+    m_flags[row_] |= flags_;
+    if (row_ == boundary_)
+        return;
+
+    for (std::uint32_t parent = m_parents[row_]; parent != none; parent = m_parents[parent])
+    {
+        if (m_flags[parent] & flag_descendant_changed)
+            return;
+        m_flags[parent] |= flag_descendant_changed;
+        if (parent == boundary_)
+            return;
+    }
+}
+
+void WidgetStorage::p_unlink(std::uint32_t row_)
+{
+    std::uint32_t parent = m_parents[row_];
+
+    std::uint32_t previous = none;
+    for (std::uint32_t child = m_first_children[parent]; child != row_; child = m_next_siblings[child])
+        previous = child;
+
+    if (previous == none)
+        m_first_children[parent] = m_next_siblings[row_];
+    else
+        m_next_siblings[previous] = m_next_siblings[row_];
+    if (m_last_children[parent] == row_)
+        m_last_children[parent] = previous;
+
+    m_parents[row_] = none;
+    m_next_siblings[row_] = none;
+    m_is_sorted = false;
+}
+
+//
+// Drops the measures of the widget, and of every ancestor whose size depends on it, up to the first one
+// whose size does not: a widget that is not laid out by a parent, or whose width and height are both fixed.
+// That relayout boundary and every widget below it are laid out again, the rest of the tree is not.
+//
+void WidgetStorage::p_invalidate_layout(std::uint32_t row_)
+{
+    m_change_count++;
+
+    std::uint32_t row = row_;
+    while (true)
+    {
+        m_measure_caches[row].clear();
+        m_layout_flags[row] |= layout_dirty;
+
+        const LayoutStyle& style = m_layout_styles[row];
+        bool is_fixed = style.width != LayoutStyle::auto_size && style.height != LayoutStyle::auto_size;
+        if (is_fixed || m_parents[row] == none || !p_is_flex_container(m_parents[row]))
+            break;
+        row = m_parents[row];
+    }
+    p_mark_layout(row);
+}
+
+//
+// Lays out the widget again, and marks every ancestor as leading to it, stopping at the first one already marked.
+//
+void WidgetStorage::p_mark_layout(std::uint32_t row_)
+{
+    m_layout_flags[row_] |= layout_dirty;
+    for (std::uint32_t parent = m_parents[row_]; parent != none; parent = m_parents[parent])
+    {
+        if (m_layout_flags[parent] & layout_descendant_dirty)
+            return;
+        m_layout_flags[parent] |= layout_descendant_dirty;
+    }
+}
+
+bool WidgetStorage::p_is_flex_container(std::uint32_t row_) const
+{
+    return m_layout_styles[row_].direction != FlexDirection::none;
+}
+
+//
+// Sets a rect computed by the layout, marking ancestors up to the boundary. Returns whether the size changed.
+//
+bool WidgetStorage::p_set_layout_rect(std::uint32_t row_, const Rect& rect_, std::uint32_t boundary_)
+{
+    if (is_same_rect(m_rects[row_], rect_))
+        return false;
+
+    bool is_resized = !is_same_size(m_rects[row_], rect_);
+    m_rects[row_] = rect_;
+    p_mark(row_, flag_moved, boundary_);
+    return is_resized;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,216 @@
+#include <MapleUI/delegate.h>
+
+#include <cstdlib>
+#include <iostream>
+
+//
+// Checks Delegate storage and calls, and Signal slots that connect, disconnect or throw while the signal is emitted.
+//
+
+
+
+namespace
+{
+
+using namespace maple;
+
+bool check_result(const std::string& name_, const std::string& difference_)
+{
+    if (difference_.empty())
+        std::cout << "PASS " << name_ << "\n";
+    else
+        std::cout << "FAIL " << name_ << ": " << difference_ << "\n";
+    return difference_.empty();
+}
+
+std::string compare_calls(const std::vector<int>& actual_, const std::vector<int>& expected_)
+{
+    if (actual_ == expected_)
+        return {};
+
+    auto join = [](const std::vector<int>& calls_)
+        {
+            std::string text;
+            for (int call : calls_)
+                text += (text.empty() ? "" : " ") + std::to_string(call);
+            return "[" + text + "]";
+        };
+    return "calls are " + join(actual_) + " instead of " + join(expected_);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Small callables are stored inline, large ones on the heap, and both survive being moved.
+//
+bool check_delegate()
+{
+    int value = 0;
+    Delegate<int(int)> small = [&value](int add_) { return value += add_; };
+
+    std::array<int, 32> payload{};
+    payload[31] = 5;
+    Delegate<int(int)> large = [payload](int add_) { return payload[31] + add_; };
+
+    std::string difference;
+    if (!small.is_inline())
+        difference = "a lambda capturing one reference is not inline";
+    else if (large.is_inline())
+        difference = "a lambda capturing 128 bytes is inline";
+
+    Delegate<int(int)> moved_small = std::move(small);
+    Delegate<int(int)> moved_large;
+    moved_large = std::move(large);
+    if (difference.empty() && (small || large))
+        difference = "a moved-from delegate is not empty";
+    if (difference.empty() && (moved_small(2) != 2 || moved_small(3) != 5))
+        difference = "the inline delegate returned a wrong value";
+    if (difference.empty() && moved_large(1) != 6)
+        difference = "the heap delegate returned a wrong value";
+
+    if (difference.empty())
+    {
+        Delegate<void()> empty = nullptr;
+        try
+        {
+            empty();
+            difference = "calling an empty delegate did not throw";
+        }
+        catch (const std::runtime_error&) {}
+    }
+    return check_result("delegate", difference);
+}
+
+//
+// A slot connected during an emit is first called by the next emit.
+//
+bool check_connect_while_emitting()
+{
+    Signal<void(int)> signal;
+    std::vector<int> calls;
+
+    bool is_connected = false;
+    signal.connect([&](int value_)
+        {
+            calls.push_back(value_);
+            if (!std::exchange(is_connected, true))
+                signal.connect([&calls](int value_) { calls.push_back(value_ * 10); });
+        });
+
+    signal.emit(1);
+    std::string difference = compare_calls(calls, { 1 });
+
+    signal.emit(2);
+    if (difference.empty())
+        difference = compare_calls(calls, { 1, 2, 20 });
+    if (difference.empty() && signal.get_slot_count() != 2)
+        difference = std::to_string(signal.get_slot_count()) + " slots instead of 2";
+    return check_result("connect_while_emitting", difference);
+}
+
+//
+// A slot disconnecting itself, and one disconnecting a later slot, in the same emit.
+//
+bool check_disconnect_while_emitting()
+{
+    Signal<void(int)> signal;
+    std::vector<int> calls;
+
+    Signal<void(int)>::Connection self = 0, later = 0;
+    self = signal.connect([&](int value_)
+        {
+            calls.push_back(value_);
+            signal.disconnect(self);
+        });
+    signal.connect([&](int value_)
+        {
+            calls.push_back(value_ * 10);
+            signal.disconnect(later);
+        });
+    later = signal.connect([&calls](int value_) { calls.push_back(value_ * 100); });
+
+    signal.emit(1);
+    std::string difference = compare_calls(calls, { 1, 10 });
+
+    signal.emit(2);
+    if (difference.empty())
+        difference = compare_calls(calls, { 1, 10, 20 });
+    if (difference.empty() && signal.get_slot_count() != 1)
+        difference = std::to_string(signal.get_slot_count()) + " slots instead of 1";
+    return check_result("disconnect_while_emitting", difference);
+}
+
+//
+// A throwing slot ends the emit, and slots connected afterwards are called by the next emit.
+//
+bool check_throw_while_emitting()
+{
+    Signal<void(int)> signal;
+    std::vector<int> calls;
+
+    auto throwing = signal.connect([](int) { throw std::runtime_error("slot"); });
+    signal.connect([&calls](int value_) { calls.push_back(value_); });
+
+    std::string difference;
+    try
+    {
+        signal.emit(1);
+        difference = "the exception of the slot was not propagated";
+    }
+    catch (const std::runtime_error&) {}
+
+    signal.disconnect(throwing);
+    signal.connect([&calls](int value_) { calls.push_back(value_ * 10); });
+    signal.emit(2);
+
+    if (difference.empty())
+        difference = compare_calls(calls, { 2, 20 });
+    if (difference.empty() && signal.get_slot_count() != 2)
+        difference = std::to_string(signal.get_slot_count()) + " slots instead of 2";
+    return check_result("throw_while_emitting", difference);
+}
+
+//
+// An emit from inside a slot calls every slot again, and slots connected by either emit
+// are only merged once the outer emit returns.
+//
+bool check_nested_emit()
+{
+    Signal<void(int)> signal;
+    std::vector<int> calls;
+
+    signal.connect([&](int value_)
+        {
+            calls.push_back(value_);
+            if (value_ == 1)
+            {
+                signal.emit(2);
+                signal.connect([&calls](int value_) { calls.push_back(value_ * 10); });
+            }
+        });
+
+    signal.emit(1);
+    std::string difference = compare_calls(calls, { 1, 2 });
+
+    calls.clear();
+    signal.emit(3);
+    if (difference.empty())
+        difference = compare_calls(calls, { 3, 30 });
+    return check_result("nested_emit", difference);
+}
+
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    bool is_passed = true;
+    is_passed &= check_delegate();
+    is_passed &= check_connect_while_emitting();
+    is_passed &= check_disconnect_while_emitting();
+    is_passed &= check_throw_while_emitting();
+    is_passed &= check_nested_emit();
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+#include <MapleUI/frame_scheduler.h>
+
+#include <cstdlib>
+#include <iostream>
+
+//
+// Fires timers and animations of a FrameScheduler at chosen times, without waiting for the clock,
+// and checks that a deadline fired early within the coalescing slack is not fired again in the same period.
+//
+
+
+
+namespace
+{
+
+using namespace maple;
+using namespace std::chrono_literals;
+
+bool check_result(const std::string& name_, const std::string& difference_)
+{
+    if (difference_.empty())
+        std::cout << "PASS " << name_ << "\n";
+    else
+        std::cout << "FAIL " << name_ << ": " << difference_ << "\n";
+    return difference_.empty();
+}
+
+std::string compare_count(const std::string& name_, std::size_t actual_, std::size_t expected_)
+{
+    if (actual_ == expected_)
+        return {};
+    return name_ + " is " + std::to_string(actual_) + " instead of " + std::to_string(expected_);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Fires a repeating timer a little before each deadline, and once more at the deadline itself.
+//
+bool check_repeating_within_slack()
+{
+    auto scheduler = FrameScheduler::create();
+    scheduler->set_coalescing_slack(4ms);
+
+    std::size_t calls = 0;
+    scheduler->add_repeating_timer(20ms, [&calls]() { calls++; });
+
+    std::string difference;
+    for (std::size_t period = 1; period <= 5 && difference.empty(); period++)
+    {
+        auto deadline = *scheduler->get_next_deadline();
+        scheduler->run_due(deadline - 3ms);
+        scheduler->run_due(deadline - 1ms);
+        scheduler->run_due(deadline);
+        difference = compare_count("calls after period " + std::to_string(period), calls, period);
+
+        if (difference.empty() && *scheduler->get_next_deadline() != deadline + 20ms)
+            difference = "the next deadline is not one interval later";
+    }
+    return check_result("repeating_within_slack", difference);
+}
+
+//
+// Fires an animation a little before each frame boundary, and once more at the boundary itself.
+// The animation ends with exactly 1, after one call per frame.
+//
+bool check_animation_within_slack()
+{
+    auto scheduler = FrameScheduler::create();
+    scheduler->set_frame_interval(10ms);
+    scheduler->set_coalescing_slack(2ms);
+
+    std::vector<float> progress;
+    scheduler->add_animation(95ms, [&progress](float progress_) { progress.push_back(progress_); });
+
+    std::string difference;
+    std::size_t frames = 0;
+    while (auto deadline = scheduler->get_next_deadline())
+    {
+        frames++;
+        scheduler->run_due(*deadline - 1ms);
+        scheduler->run_due(*deadline);
+        difference = compare_count("calls after frame " + std::to_string(frames), progress.size(), frames);
+        if (!difference.empty() || frames > 20)
+            break;
+    }
+
+    if (difference.empty() && (progress.empty() || progress.back() != 1.0f))
+        difference = "the last progress is not 1";
+    if (difference.empty() && (frames < 9 || frames > 11))
+        difference = "the animation took " + std::to_string(frames) + " frames";
+    return check_result("animation_within_slack", difference);
+}
+
+//
+// A one-shot timer fired early within the slack fires once, and a timer outside the slack waits.
+//
+bool check_single_within_slack()
+{
+    auto scheduler = FrameScheduler::create();
+    scheduler->set_coalescing_slack(4ms);
+
+    std::size_t near_calls = 0, far_calls = 0;
+    scheduler->add_timer(10ms, [&near_calls]() { near_calls++; });
+    scheduler->add_timer(30ms, [&far_calls]() { far_calls++; });
+
+    auto deadline = *scheduler->get_next_deadline();
+    scheduler->run_due(deadline - 2ms);
+    scheduler->run_due(deadline);
+
+    std::string difference = compare_count("near calls", near_calls, 1);
+    if (difference.empty())
+        difference = compare_count("far calls", far_calls, 0);
+    return check_result("single_within_slack", difference);
+}
+
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    bool is_passed = true;
+    is_passed &= check_repeating_within_slack();
+    is_passed &= check_animation_within_slack();
+    is_passed &= check_single_within_slack();
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,450 @@
+#include <MapleUI/context.h>
+#include <MapleUI/painter.h>
+
+#include <cstdlib>
+
+//
+// Draws fixed scenes in a headless Context, reads them back through Window::capture
+// and compares them with the reference images in tests/golden.
+// Also checks that redrawing only the damaged parts of a window, after invalidating them by hand
+// or after changing its widget tree, gives the same pixels as a full redraw, and that laying out
+// again only what a change affected places widgets where laying out a fresh tree does.
+//
+//     TestGolden [--update] [--tolerance N]
+//
+// --update rewrites the references from the current output, once a change of the output was reviewed.
+// A pixel matches when no channel differs by more than the tolerance, 2 by default, since drivers
+// are free to round blending differently. Mismatching output is written to <scene>.actual.ppm.
+//
+
+#ifndef MAPLE_GOLDEN_DIRECTORY
+    #define MAPLE_GOLDEN_DIRECTORY "golden"
+#endif
+
+
+
+namespace
+{
+
+using namespace maple;
+
+struct Options
+{
+    bool is_updating{ false };
+    int tolerance{ 2 };
+};
+
+struct Scene
+{
+    std::string name;
+    void (*paint)(Painter&);
+};
+
+constexpr Size scene_size{ .width = 96, .height = 64 };
+
+std::vector<Scene> get_scenes()
+{
+    return {
+        { "rects", [](Painter& painter_)
+            {
+                for (int y = 0; y < 4; y++)
+                    for (int x = 0; x < 6; x++)
+                        painter_.fill_rect(Rect{ .x = x * 16 + 2, .y = y * 16 + 2, .width = 12, .height = 12 },
+                                           Color{ .r = x / 5.0f, .g = y / 3.0f, .b = 0.5f, .a = 1.0f });
+            } },
+        { "blend", [](Painter& painter_)
+            {
+                painter_.fill_rect(Rect{ .x = 8, .y = 8, .width = 48, .height = 40 },
+                                   Color{ .r = 1.0f, .g = 0.0f, .b = 0.0f, .a = 0.5f });
+                painter_.fill_rect(Rect{ .x = 32, .y = 16, .width = 48, .height = 40 },
+                                   Color{ .r = 0.0f, .g = 0.0f, .b = 1.0f, .a = 0.5f });
+                painter_.fill_rect(Rect{ .x = 20, .y = 24, .width = 40, .height = 16 },
+                                   Color{ .r = 0.0f, .g = 1.0f, .b = 0.0f, .a = 0.25f });
+            } },
+        { "rounded", [](Painter& painter_)
+            {
+                painter_.fill_rect(Rect{ .x = 4, .y = 4, .width = 40, .height = 56 },
+                                   Color{ .r = 0.2f, .g = 0.6f, .b = 0.3f, .a = 1.0f }, 12.0f);
+                painter_.fill_rect(Rect{ .x = 52, .y = 12, .width = 40, .height = 40 },
+                                   Color{ .r = 0.8f, .g = 0.4f, .b = 0.1f, .a = 0.75f }, 20.0f);
+            } },
+    };
+}
+
+//
+// Draws until the capture arrives, which takes a few frames since the readback never stalls.
+//
+Image capture(std::shared_ptr<Context>& context_, std::shared_ptr<Window>& window_)
+{
+    std::optional<Image> image;
+    window_->capture([&image](const Image& image_) { image = image_; });
+    for (int i = 0; i < 100 && !image; i++)
+        context_->draw();
+
+    if (!image)
+        throw std::runtime_error("Image capture(...): The capture was never delivered.");
+    return *image;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Binary PPM, which stores no alpha. Windows are opaque, so only the color channels are compared.
+//
+void write_ppm(const std::filesystem::path& path_, const Image& image_)
+{
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    file << "P6\n" << image_.size.width << " " << image_.size.height << "\n255\n";
+    for (std::size_t i = 0; i < image_.pixels.size(); i += 4)
+        file.write(reinterpret_cast<const char*>(&image_.pixels[i]), 3);
+    if (!file)
+        throw std::runtime_error("void write_ppm(...): Failed to write " + path_.string() + ".");
+}
+
+std::optional<Image> read_ppm(const std::filesystem::path& path_)
+{
+    std::ifstream file(path_, std::ios::binary);
+    std::string magic;
+    int max_value = 0;
+    Image image;
+    if (!(file >> magic >> image.size.width >> image.size.height >> max_value) || magic != "P6" || max_value != 255)
+        return std::nullopt;
+    file.get();
+
+    image.pixels.resize(static_cast<std::size_t>(image.size.width) * image.size.height * 4);
+    for (std::size_t i = 0; i < image.pixels.size(); i += 4)
+    {
+        file.read(reinterpret_cast<char*>(&image.pixels[i]), 3);
+        image.pixels[i + 3] = 255;
+    }
+    if (!file)
+        return std::nullopt;
+    return image;
+}
+
+//
+// Returns an empty string when the images match, and a description of the difference otherwise.
+//
+std::string compare(const Image& actual_, const Image& expected_, int tolerance_)
+{
+    if (actual_.size.width != expected_.size.width || actual_.size.height != expected_.size.height)
+        return "size " + std::to_string(actual_.size.width) + "x" + std::to_string(actual_.size.height) +
+               " instead of " + std::to_string(expected_.size.width) + "x" + std::to_string(expected_.size.height);
+
+    std::size_t mismatches = 0;
+    int max_difference = 0;
+    for (std::size_t i = 0; i < actual_.pixels.size(); i += 4)
+    {
+        int difference = 0;
+        for (std::size_t c = 0; c < 3; c++)
+            difference = std::max(difference, std::abs(actual_.pixels[i + c] - expected_.pixels[i + c]));
+
+        max_difference = std::max(max_difference, difference);
+        if (difference > tolerance_)
+            mismatches++;
+    }
+
+    if (mismatches == 0)
+        return {};
+    return std::to_string(mismatches) + " pixels differ, by up to " + std::to_string(max_difference);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+bool check_golden(const Scene& scene_, const Image& image_, const Options& options_)
+{
+    std::filesystem::path reference = std::filesystem::path(MAPLE_GOLDEN_DIRECTORY) / (scene_.name + ".ppm");
+    if (options_.is_updating)
+    {
+        write_ppm(reference, image_);
+        std::cout << "UPDATED " << scene_.name << "\n";
+        return true;
+    }
+
+    auto expected = read_ppm(reference);
+    std::string difference = expected ? compare(image_, *expected, options_.tolerance)
+                                      : "missing reference " + reference.string();
+    if (difference.empty())
+    {
+        std::cout << "PASS " << scene_.name << "\n";
+        return true;
+    }
+
+    write_ppm(scene_.name + ".actual.ppm", image_);
+    std::cout << "FAIL " << scene_.name << ": " << difference << "\n";
+    return false;
+}
+
+bool check_result(const std::string& name_, const std::string& difference_)
+{
+    if (difference_.empty())
+        std::cout << "PASS " << name_ << "\n";
+    else
+        std::cout << "FAIL " << name_ << ": " << difference_ << "\n";
+    return difference_.empty();
+}
+
+//
+// Moves a rect after the first frame and only invalidates where it was and where it is,
+// then compares the result with a window that drew the moved rect from scratch.
+//
+bool check_damage_redraw(std::shared_ptr<Context>& context_)
+{
+    Rect before{ .x = 10, .y = 10, .width = 20, .height = 20 };
+    Rect after{ .x = 50, .y = 30, .width = 20, .height = 20 };
+
+    auto paint = [](const Rect& moving_)
+        {
+            return [moving_](Painter& painter_)
+                {
+                    painter_.fill_rect(Rect{ .x = 0, .y = 0, .width = 96, .height = 64 },
+                                       Color{ .r = 0.9f, .g = 0.9f, .b = 0.8f, .a = 1.0f });
+                    painter_.fill_rect(Rect{ .x = 20, .y = 20, .width = 40, .height = 20 },
+                                       Color{ .r = 0.1f, .g = 0.3f, .b = 0.7f, .a = 0.6f });
+                    painter_.fill_rect(moving_, Color{ .r = 0.8f, .g = 0.2f, .b = 0.2f, .a = 0.5f }, 4.0f);
+                };
+        };
+
+    auto damaged = Window::create(context_, WindowProperties{ .size = scene_size, .position = {}, .title = "damage" });
+    damaged->on_paint(paint(before));
+    capture(context_, damaged);
+    damaged->on_paint(paint(after));
+    damaged->invalidate(before);
+    damaged->invalidate(after);
+    Image partial = capture(context_, damaged);
+
+    auto full = Window::create(context_, WindowProperties{ .size = scene_size, .position = {}, .title = "full" });
+    full->on_paint(paint(after));
+    Image complete = capture(context_, full);
+
+    bool is_passed = check_result("damage_redraw", compare(partial, complete, 0));
+
+    damaged->close();
+    full->close();
+    context_->draw();
+    return is_passed;
+}
+
+//
+// Builds the same widget tree in two windows, changes one of them after the first frame,
+// and compares it with a window that built the changed tree from scratch.
+//
+bool check_widget_redraw(std::shared_ptr<Context>& context_)
+{
+    struct Widgets
+    {
+        std::shared_ptr<Frame> panel;
+        std::shared_ptr<Frame> button;
+        std::shared_ptr<Frame> badge;
+    };
+
+    auto build = [](Window& window_)
+        {
+            auto root = window_.get_root();
+            Frame::create(root, Rect{ .x = 0, .y = 0, .width = 96, .height = 64 },
+                          Color{ .r = 0.9f, .g = 0.9f, .b = 0.9f, .a = 1.0f });
+            auto panel = Frame::create(root, Rect{ .x = 4, .y = 4, .width = 56, .height = 40 },
+                                       Color{ .r = 0.2f, .g = 0.3f, .b = 0.6f, .a = 1.0f });
+            auto button = Frame::create(panel, Rect{ .x = 4, .y = 4, .width = 20, .height = 12 },
+                                        Color{ .r = 0.9f, .g = 0.6f, .b = 0.1f, .a = 0.8f });
+            auto badge = Frame::create(button, Rect{ .x = 14, .y = 2, .width = 4, .height = 4 },
+                                       Color{ .r = 1.0f, .g = 0.0f, .b = 0.0f, .a = 1.0f });
+            Frame::create(panel, Rect{ .x = 30, .y = 20, .width = 20, .height = 12 },
+                          Color{ .r = 0.1f, .g = 0.8f, .b = 0.3f, .a = 1.0f });
+            return Widgets{ .panel = panel, .button = button, .badge = badge };
+        };
+
+    auto change = [](const Widgets& widgets_)
+        {
+            widgets_.panel->set_rect(Rect{ .x = 36, .y = 20, .width = 56, .height = 40 });
+            widgets_.button->set_color(Color{ .r = 0.5f, .g = 0.1f, .b = 0.7f, .a = 0.8f });
+            widgets_.badge->remove();
+        };
+
+    auto changed = Window::create(context_, WindowProperties{ .size = scene_size, .position = {}, .title = "changed" });
+    Widgets widgets = build(*changed);
+    capture(context_, changed);
+    change(widgets);
+    Image partial = capture(context_, changed);
+
+    auto full = Window::create(context_, WindowProperties{ .size = scene_size, .position = {}, .title = "full" });
+    change(build(*full));
+    Image complete = capture(context_, full);
+
+    bool is_passed = check_result("widget_redraw", compare(partial, complete, 0));
+
+    changed->close();
+    full->close();
+    context_->draw();
+    return is_passed;
+}
+
+//
+// A widget with content of a given size, standing in for text.
+//
+class Label : public Frame
+{
+public:
+    static std::shared_ptr<Label> create(std::shared_ptr<Object> parent_, const Size& content_size_)
+    {
+        struct MakeSharedEnabler : public Label
+        {
+            MakeSharedEnabler(std::shared_ptr<Object> parent_)
+                : Label(parent_) {}
+        };
+        auto label = std::make_shared<MakeSharedEnabler>(parent_);
+        label->set_content_size(content_size_);
+        label->set_color(Color{ .r = 0.9f, .g = 0.8f, .b = 0.2f, .a = 1.0f });
+        parent_->add_child(label);
+        return label;
+    }
+
+protected:
+    Label(std::shared_ptr<Object> parent_)
+        : Frame(parent_)
+    {
+        set_custom_measure(true);
+    }
+
+public:
+    virtual Size measure(const LayoutConstraints&) override
+    {
+        return m_content_size;
+    }
+
+    void set_content_size(const Size& content_size_)
+    {
+        m_content_size = content_size_;
+        invalidate_layout();
+    }
+
+private:
+    Size m_content_size{};
+};
+
+std::string compare_rect(const std::string& name_, const Rect& actual_, const Rect& expected_)
+{
+    if (actual_.x == expected_.x && actual_.y == expected_.y
+        && actual_.width == expected_.width && actual_.height == expected_.height)
+        return {};
+    return name_ + " is at " + std::to_string(actual_.x) + ", " + std::to_string(actual_.y) + ", "
+         + std::to_string(actual_.width) + " x " + std::to_string(actual_.height);
+}
+
+bool check_flex_layout(std::shared_ptr<Context>& context_)
+{
+    struct Widgets
+    {
+        std::shared_ptr<Label> first;
+        std::shared_ptr<Label> second;
+        std::shared_ptr<Frame> spacer;
+        std::shared_ptr<Label> status;
+    };
+
+    auto build = [](Window& window_, const Size& second_size_)
+        {
+            auto root = window_.get_root();
+            root->set_color(Color{ .r = 0.9f, .g = 0.9f, .b = 0.9f, .a = 1.0f });
+            root->set_layout_style(LayoutStyle{ .direction = FlexDirection::column, .padding = 4, .gap = 4 });
+
+            auto header = Frame::create(root);
+            header->set_color(Color{ .r = 0.2f, .g = 0.3f, .b = 0.6f, .a = 1.0f });
+            header->set_layout_style(LayoutStyle{ .height = 12 });
+
+            auto row = Frame::create(root);
+            row->set_color(Color{ .r = 0.7f, .g = 0.7f, .b = 0.8f, .a = 1.0f });
+            row->set_layout_style(LayoutStyle{ .direction = FlexDirection::row, .align = FlexAlign::center,
+                                               .gap = 2, .grow = 1.0f });
+            auto first = Label::create(row, Size{ .width = 20, .height = 10 });
+            auto second = Label::create(row, second_size_);
+            auto spacer = Frame::create(row);
+            spacer->set_color(Color{ .r = 0.1f, .g = 0.8f, .b = 0.3f, .a = 1.0f });
+            spacer->set_layout_style(LayoutStyle{ .height = 4, .grow = 1.0f });
+            Label::create(row, Size{ .width = 8, .height = 8 });
+
+            auto footer = Frame::create(root);
+            footer->set_color(Color{ .r = 0.3f, .g = 0.3f, .b = 0.3f, .a = 1.0f });
+            footer->set_layout_style(LayoutStyle{ .direction = FlexDirection::row, .justify = FlexJustify::end,
+                                                  .align = FlexAlign::start, .height = 10 });
+            auto status = Label::create(footer, Size{ .width = 16, .height = 6 });
+            return Widgets{ .first = first, .second = second, .spacer = spacer, .status = status };
+        };
+
+    auto changed = Window::create(context_, WindowProperties{ .size = scene_size, .position = {}, .title = "changed" });
+    Widgets widgets = build(*changed, Size{ .width = 12, .height = 16 });
+    capture(context_, changed);
+    std::string difference = compare_rect("second", widgets.second->get_rect(),
+                                          Rect{ .x = 22, .y = 5, .width = 12, .height = 16 });
+    if (difference.empty())
+        difference = compare_rect("spacer", widgets.spacer->get_rect(),
+                                  Rect{ .x = 36, .y = 11, .width = 42, .height = 4 });
+    if (difference.empty())
+        difference = compare_rect("status", widgets.status->get_world_rect(),
+                                  Rect{ .x = 76, .y = 50, .width = 16, .height = 6 });
+    bool is_passed = check_result("flex_layout_rects", difference);
+
+    widgets.second->set_content_size(Size{ .width = 30, .height = 20 });
+    Image partial = capture(context_, changed);
+
+    auto full = Window::create(context_, WindowProperties{ .size = scene_size, .position = {}, .title = "full" });
+    build(*full, Size{ .width = 30, .height = 20 });
+    Image complete = capture(context_, full);
+
+    is_passed &= check_result("flex_relayout", compare(partial, complete, 0));
+
+    changed->close();
+    full->close();
+    context_->draw();
+    return is_passed;
+}
+
+Options parse_options(int argc_, char** argv_)
+{
+    Options options;
+    for (int i = 1; i < argc_; i++)
+    {
+        std::string_view key = argv_[i];
+        if (key == "--update")
+            options.is_updating = true;
+        else if (key == "--tolerance" && i + 1 < argc_)
+            options.tolerance = std::stoi(argv_[++i]);
+        else
+            throw std::runtime_error("Options parse_options(int, char**): Unknown option " + std::string(key) + ".");
+    }
+    return options;
+}
+
+}
+
+
+
+int main(int argc, char** argv)
+{
+    Options options = parse_options(argc, argv);
+
+    auto context = Context::create(ContextProperties{ .shader_cache_directory = {},
+                                                      .is_headless = true,
+                                                      .is_render_thread_enabled = false });
+
+    bool is_passed = true;
+    for (auto& scene : get_scenes())
+    {
+        auto window = Window::create(context, WindowProperties{ .size = scene_size, .position = {}, .title = scene.name });
+        window->on_paint(scene.paint);
+        Image image = capture(context, window);
+        is_passed &= check_golden(scene, image, options);
+
+        // the synchronous readback has to agree with the asynchronous one
+        Image read{ .size = window->get_framebuffer_size(), .pixels = window->read_pixels() };
+        is_passed &= check_result(scene.name + "_read_pixels", compare(read, image, 0));
+
+        window->close();
+        context->draw();
+    }
+
+    is_passed &= check_damage_redraw(context);
+    is_passed &= check_widget_redraw(context);
+    is_passed &= check_flex_layout(context);
+
+    return is_passed ? 0 : 1;
+}
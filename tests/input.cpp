@@ -0,0 +1,230 @@
+#include <MapleUI/input.h>
+
+#include <cstdlib>
+#include <iostream>
+
+//
+// Pushes interleaved moves, scrolls, resizes and buttons into an InputQueue, and checks which events
+// are merged, the values the merged events keep, and the raw events their history spans.
+//
+
+
+
+namespace
+{
+
+using namespace maple;
+
+bool check_result(const std::string& name_, const std::string& difference_)
+{
+    if (difference_.empty())
+        std::cout << "PASS " << name_ << "\n";
+    else
+        std::cout << "FAIL " << name_ << ": " << difference_ << "\n";
+    return difference_.empty();
+}
+
+std::string compare_count(const std::string& name_, std::size_t actual_, std::size_t expected_)
+{
+    if (actual_ == expected_)
+        return {};
+    return name_ + " is " + std::to_string(actual_) + " instead of " + std::to_string(expected_);
+}
+
+std::string compare_value(const std::string& name_, double actual_, double expected_)
+{
+    if (actual_ == expected_)
+        return {};
+    return name_ + " is " + std::to_string(actual_) + " instead of " + std::to_string(expected_);
+}
+
+InputEvent make_event(InputEventType type_, double x_ = 0.0, double y_ = 0.0)
+{
+    static auto time = InputEvent::Clock::now();
+    time += std::chrono::milliseconds(1);
+    return InputEvent{ .type = type_, .time = time, .x = x_, .y = y_ };
+}
+
+//
+// The event merged from the raw events history_begin to history_begin + history_count - 1.
+//
+std::string compare_span(const InputQueue& queue_, std::size_t index_, std::size_t begin_, std::size_t count_)
+{
+    auto& event = queue_.get_events()[index_];
+    std::string name = "event " + std::to_string(index_);
+    std::string difference = compare_count(name + " history_begin", event.history_begin, begin_);
+    if (difference.empty())
+        difference = compare_count(name + " history_count", event.history_count, count_);
+    if (difference.empty() && event.time != queue_.get_history()[begin_ + count_ - 1].time)
+        difference = name + " does not have the time of its newest raw event";
+    if (difference.empty())
+    {
+        auto history = queue_.get_history(event);
+        if (history.data() != queue_.get_history().data() + begin_ || history.size() != count_)
+            difference = "the history of " + name + " is not its raw events";
+    }
+    return difference;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Moves keep the newest position, and a button between two runs of moves ends the first run.
+//
+bool check_moves_around_button()
+{
+    InputQueue queue;
+    queue.push(make_event(InputEventType::cursor_move, 1.0, 2.0));
+    queue.push(make_event(InputEventType::cursor_move, 3.0, 4.0));
+    queue.push(make_event(InputEventType::cursor_move, 5.0, 6.0));
+    queue.push(make_event(InputEventType::mouse_button));
+    queue.push(make_event(InputEventType::cursor_move, 7.0, 8.0));
+    queue.push(make_event(InputEventType::cursor_move, 9.0, 10.0));
+
+    auto& events = queue.get_events();
+    std::string difference = compare_count("event count", events.size(), 3);
+    if (difference.empty())
+        difference = compare_count("history size", queue.get_history().size(), 6);
+    if (difference.empty() && (events[0].type != InputEventType::cursor_move
+                               || events[1].type != InputEventType::mouse_button
+                               || events[2].type != InputEventType::cursor_move))
+        difference = "the events are not move, button, move";
+    if (difference.empty())
+        difference = compare_value("first x", events[0].x, 5.0);
+    if (difference.empty())
+        difference = compare_value("first y", events[0].y, 6.0);
+    if (difference.empty())
+        difference = compare_value("last x", events[2].x, 9.0);
+    if (difference.empty())
+        difference = compare_span(queue, 0, 0, 3);
+    if (difference.empty())
+        difference = compare_span(queue, 1, 3, 1);
+    if (difference.empty())
+        difference = compare_span(queue, 2, 4, 2);
+    return check_result("moves_around_button", difference);
+}
+
+//
+// Scrolls add up, and alternating moves and scrolls are never merged with each other.
+//
+bool check_interleaved_scrolls()
+{
+    InputQueue queue;
+    queue.push(make_event(InputEventType::scroll, 0.0, 1.0));
+    queue.push(make_event(InputEventType::scroll, 0.5, 2.0));
+    queue.push(make_event(InputEventType::scroll, 0.0, -0.5));
+    queue.push(make_event(InputEventType::cursor_move, 10.0, 10.0));
+    queue.push(make_event(InputEventType::scroll, 1.0, 1.0));
+    queue.push(make_event(InputEventType::cursor_move, 20.0, 20.0));
+    queue.push(make_event(InputEventType::cursor_move, 30.0, 30.0));
+
+    auto& events = queue.get_events();
+    std::string difference = compare_count("event count", events.size(), 4);
+    if (difference.empty())
+        difference = compare_value("summed scroll x", events[0].x, 0.5);
+    if (difference.empty())
+        difference = compare_value("summed scroll y", events[0].y, 2.5);
+    if (difference.empty())
+        difference = compare_value("second scroll y", events[2].y, 1.0);
+    if (difference.empty())
+        difference = compare_value("last move x", events[3].x, 30.0);
+    if (difference.empty())
+        difference = compare_span(queue, 0, 0, 3);
+    if (difference.empty())
+        difference = compare_span(queue, 1, 3, 1);
+    if (difference.empty())
+        difference = compare_span(queue, 2, 4, 1);
+    if (difference.empty())
+        difference = compare_span(queue, 3, 5, 2);
+    if (difference.empty() && queue.get_history()[1].y != 2.0)
+        difference = "the history holds summed values instead of raw ones";
+    return check_result("interleaved_scrolls", difference);
+}
+
+//
+// Resizes keep the newest size, and keys and characters are never merged, not even with their own type.
+//
+bool check_resizes_and_keys()
+{
+    InputQueue queue;
+    for (int width : { 100, 200, 300 })
+    {
+        auto event = make_event(InputEventType::framebuffer_resize);
+        event.size = Size{ .width = width, .height = width / 2 };
+        queue.push(event);
+    }
+    queue.push(make_event(InputEventType::key));
+    queue.push(make_event(InputEventType::key));
+    queue.push(make_event(InputEventType::character));
+    queue.push(make_event(InputEventType::character));
+
+    auto& events = queue.get_events();
+    std::string difference = compare_count("event count", events.size(), 5);
+    if (difference.empty() && (events[0].size.width != 300 || events[0].size.height != 150))
+        difference = "the resize does not have the newest size";
+    if (difference.empty())
+        difference = compare_span(queue, 0, 0, 3);
+    for (std::size_t i = 1; i < 5 && difference.empty(); i++)
+        difference = compare_span(queue, i, i + 2, 1);
+    return check_result("resizes_and_keys", difference);
+}
+
+//
+// get_history rejects events whose span does not lie within the queue, and clear empties both lists.
+//
+bool check_history_bounds()
+{
+    InputQueue queue;
+    queue.push(make_event(InputEventType::cursor_move));
+    queue.push(make_event(InputEventType::cursor_move));
+
+    std::string difference;
+    auto is_rejected = [&queue](std::size_t begin_, std::size_t count_)
+        {
+            InputEvent event = make_event(InputEventType::cursor_move);
+            event.history_begin = begin_;
+            event.history_count = count_;
+            try
+            {
+                queue.get_history(event);
+                return false;
+            }
+            catch (const std::runtime_error&)
+            {
+                return true;
+            }
+        };
+
+    if (!is_rejected(1, 2))
+        difference = "a span past the end of the history was accepted";
+    else if (!is_rejected(3, 0))
+        difference = "a span starting past the end of the history was accepted";
+    else if (!is_rejected(1, std::numeric_limits<std::size_t>::max()))
+        difference = "a span whose end overflows was accepted";
+
+    if (difference.empty())
+    {
+        InputEvent merged = queue.get_events().front();
+        queue.clear();
+        if (!queue.is_empty() || !queue.get_history().empty())
+            difference = "the queue is not empty after clear";
+        else if (!is_rejected(merged.history_begin, merged.history_count))
+            difference = "an event of the cleared queue was accepted";
+    }
+    return check_result("history_bounds", difference);
+}
+
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    bool is_passed = true;
+    is_passed &= check_moves_around_button();
+    is_passed &= check_interleaved_scrolls();
+    is_passed &= check_resizes_and_keys();
+    is_passed &= check_history_bounds();
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
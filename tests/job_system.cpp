@@ -0,0 +1,324 @@
+#include <MapleUI/job_system.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+//
+// Runs fork-join groups and submitted jobs on systems with 0, 1 and 4 workers, and checks dependencies,
+// including a diamond and a random graph, exception propagation, nested waits,
+// and a waiting thread that has to sleep while a long job runs elsewhere.
+//
+
+
+
+namespace
+{
+
+using namespace maple;
+using namespace std::chrono_literals;
+
+bool check_result(const std::string& name_, const std::string& difference_)
+{
+    if (difference_.empty())
+        std::cout << "PASS " << name_ << "\n";
+    else
+        std::cout << "FAIL " << name_ << ": " << difference_ << "\n";
+    return difference_.empty();
+}
+
+std::string compare_count(const std::string& name_, std::size_t actual_, std::size_t expected_)
+{
+    if (actual_ == expected_)
+        return {};
+    return name_ + " is " + std::to_string(actual_) + " instead of " + std::to_string(expected_);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Every job of a group has run once wait returns.
+//
+std::string check_group(JobSystem& system_)
+{
+    std::atomic<std::size_t> calls{ 0 };
+    JobSystem::JobGroup group;
+    for (std::size_t i = 0; i < 1000; i++)
+        system_.run(group, [&calls]() { calls++; });
+    system_.wait(group);
+    return compare_count("calls", calls.load(), 1000);
+}
+
+//
+// A job submitted with dependencies runs after all of them, also when one of them threw,
+// and a chain of jobs runs in order.
+//
+std::string check_dependencies(JobSystem& system_)
+{
+    std::atomic<std::size_t> finished{ 0 };
+    std::vector<JobSystem::JobHandle> dependencies;
+    for (std::size_t i = 0; i < 16; i++)
+        dependencies.push_back(system_.submit([&finished, i]()
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(i * 50));
+                finished++;
+                if (i == 3)
+                    throw std::runtime_error("dependency");
+            }));
+
+    std::size_t seen = 0;
+    auto dependent = system_.submit([&]() { seen = finished.load(); }, dependencies);
+    system_.wait(dependent);
+    if (seen != 16)
+        return "the dependent saw " + std::to_string(seen) + " of 16 finished dependencies";
+
+    std::vector<int> order;
+    JobSystem::JobHandle previous = nullptr;
+    for (int i = 0; i < 50; i++)
+    {
+        std::vector<JobSystem::JobHandle> previous_job;
+        if (previous)
+            previous_job.push_back(previous);
+        previous = system_.submit([&order, i]() { order.push_back(i); }, previous_job);
+    }
+    system_.wait(previous);
+    for (int i = 0; i < 50; i++)
+        if (order.size() != 50 || order[i] != i)
+            return "the chain did not run in order";
+    return {};
+}
+
+//
+// One job with two dependents, which both feed one more job. Each of them sees every job before it finished.
+//
+std::string check_diamond(JobSystem& system_)
+{
+    for (int round = 0; round < 200; round++)
+    {
+        std::atomic<int> top{ 0 }, left{ 0 }, right{ 0 };
+        int seen_left = -1, seen_right = -1, seen_bottom = -1;
+
+        auto top_job = system_.submit([&top]() { top = 1; });
+        JobSystem::JobHandle top_dependency[] = { top_job };
+        auto left_job = system_.submit([&]() { seen_left = top.load(); left = 1; }, top_dependency);
+        auto right_job = system_.submit([&]() { seen_right = top.load(); right = 1; }, top_dependency);
+        JobSystem::JobHandle sides[] = { left_job, right_job };
+        auto bottom_job = system_.submit([&]() { seen_bottom = left.load() + right.load(); }, sides);
+        system_.wait(bottom_job);
+
+        if (seen_left != 1 || seen_right != 1)
+            return "a side ran before the top in round " + std::to_string(round);
+        if (seen_bottom != 2)
+            return "the bottom ran before both sides in round " + std::to_string(round);
+    }
+    return {};
+}
+
+//
+// A seeded random graph of 3000 jobs, each depending on up to 4 earlier ones. Jobs are submitted while
+// their dependencies run, so some finish while submit is still registering them.
+// Every job checks that all of its dependencies finished before it started.
+//
+std::string check_random_graph(JobSystem& system_)
+{
+    constexpr std::size_t job_count = 3000;
+    std::mt19937 random{ 11 };
+
+    std::vector<std::vector<std::size_t>> dependencies(job_count);
+    for (std::size_t i = 1; i < job_count; i++)
+        for (std::size_t j = 0, count = random() % 5; j < count; j++)
+            dependencies[i].push_back(random() % i);
+
+    std::unique_ptr<std::atomic<bool>[]> finished(new std::atomic<bool>[job_count]);
+    for (std::size_t i = 0; i < job_count; i++)
+        finished[i] = false;
+    std::atomic<std::size_t> unfinished_dependencies{ 0 };
+
+    std::vector<JobSystem::JobHandle> jobs;
+    jobs.reserve(job_count);
+    for (std::size_t i = 0; i < job_count; i++)
+    {
+        std::vector<JobSystem::JobHandle> handles;
+        for (std::size_t dependency : dependencies[i])
+            handles.push_back(jobs[dependency]);
+
+        jobs.push_back(system_.submit([&, i]()
+            {
+                for (std::size_t dependency : dependencies[i])
+                    if (!finished[dependency])
+                        unfinished_dependencies++;
+                finished[i] = true;
+            }, handles));
+    }
+
+    for (auto& job : jobs)
+        system_.wait(job);
+
+    if (unfinished_dependencies > 0)
+        return std::to_string(unfinished_dependencies.load()) + " dependencies had not finished when their job started";
+    for (std::size_t i = 0; i < job_count; i++)
+        if (!finished[i])
+            return "job " + std::to_string(i) + " never ran";
+    return {};
+}
+
+//
+// wait rethrows the first exception of a group, and the exception of a submitted job, every time it is waited for.
+//
+std::string check_exceptions(JobSystem& system_)
+{
+    JobSystem::JobGroup group;
+    std::atomic<std::size_t> calls{ 0 };
+    for (std::size_t i = 0; i < 100; i++)
+        system_.run(group, [&calls, i]()
+            {
+                calls++;
+                if (i % 10 == 0)
+                    throw std::runtime_error("group");
+            });
+
+    bool is_thrown = false;
+    try
+    {
+        system_.wait(group);
+    }
+    catch (const std::runtime_error&)
+    {
+        is_thrown = true;
+    }
+    if (!is_thrown)
+        return "the exception of the group was not rethrown";
+    if (calls != 100)
+        return compare_count("group calls", calls.load(), 100);
+
+    auto job = system_.submit([]() { throw std::logic_error("job"); });
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        is_thrown = false;
+        try
+        {
+            system_.wait(job);
+        }
+        catch (const std::logic_error&)
+        {
+            is_thrown = true;
+        }
+        if (!is_thrown)
+            return "the exception of the job was not rethrown by wait " + std::to_string(attempt + 1);
+    }
+    return {};
+}
+
+//
+// Jobs fork groups of their own and wait for them, several levels deep, and wait for jobs they submitted.
+//
+std::string check_nested_waits(JobSystem& system_)
+{
+    std::atomic<std::size_t> leaves{ 0 };
+    std::function<void(int)> fork = [&](int depth_)
+        {
+            if (depth_ == 0)
+            {
+                leaves++;
+                return;
+            }
+
+            JobSystem::JobGroup group;
+            for (int i = 0; i < 4; i++)
+                system_.run(group, [&fork, depth_]() { fork(depth_ - 1); });
+            system_.wait(group);
+
+            auto job = system_.submit([&leaves]() { leaves++; });
+            system_.wait(job);
+        };
+
+    JobSystem::JobGroup group;
+    system_.run(group, [&fork]() { fork(4); });
+    system_.wait(group);
+
+    // 4^4 leaves, plus one submitted job for each of the 1 + 4 + 16 + 64 inner forks
+    return compare_count("leaves", leaves.load(), 256 + 85);
+}
+
+//
+// Many threads outside the system fork and submit at once, many times.
+//
+std::string check_stress(JobSystem& system_)
+{
+    std::atomic<std::size_t> calls{ 0 };
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; t++)
+        threads.emplace_back([&]()
+            {
+                for (std::size_t round = 0; round < 200; round++)
+                {
+                    JobSystem::JobGroup group;
+                    for (std::size_t i = 0; i < 8; i++)
+                        system_.run(group, [&calls]() { calls++; });
+                    auto first = system_.submit([&calls]() { calls++; });
+                    JobSystem::JobHandle dependencies[] = { first };
+                    auto second = system_.submit([&calls]() { calls++; }, dependencies);
+                    system_.wait(group);
+                    system_.wait(second);
+                }
+            });
+    for (auto& thread : threads)
+        thread.join();
+    return compare_count("calls", calls.load(), 4 * 200 * 10);
+}
+
+//
+// A thread waiting for a long job that runs on another thread finds nothing to take, sleeps, and is woken
+// when the job finishes. Without workers the waiting thread runs the job itself.
+//
+std::string check_long_job(JobSystem& system_)
+{
+    std::atomic<bool> is_started{ false };
+    auto job = system_.submit([&is_started]()
+        {
+            is_started = true;
+            std::this_thread::sleep_for(50ms);
+        });
+
+    if (system_.get_worker_count() > 0)
+        while (!is_started)
+            std::this_thread::yield();
+
+    system_.wait(job);
+    if (!system_.is_done(job))
+        return "the job is not done after wait";
+    return {};
+}
+
+//
+// Runs every check on a system with the given number of workers.
+//
+bool check_system(std::size_t worker_count_)
+{
+    auto system = JobSystem::create(worker_count_);
+    std::string suffix = "_" + std::to_string(worker_count_) + "_workers";
+
+    bool is_passed = true;
+    is_passed &= check_result("group" + suffix, check_group(*system));
+    is_passed &= check_result("dependencies" + suffix, check_dependencies(*system));
+    is_passed &= check_result("diamond" + suffix, check_diamond(*system));
+    is_passed &= check_result("random_graph" + suffix, check_random_graph(*system));
+    is_passed &= check_result("exceptions" + suffix, check_exceptions(*system));
+    is_passed &= check_result("nested_waits" + suffix, check_nested_waits(*system));
+    is_passed &= check_result("stress" + suffix, check_stress(*system));
+    is_passed &= check_result("long_job" + suffix, check_long_job(*system));
+    return is_passed;
+}
+
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    bool is_passed = true;
+    for (std::size_t worker_count : { 0, 1, 4 })
+        is_passed &= check_system(worker_count);
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
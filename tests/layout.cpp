@@ -0,0 +1,312 @@
+#include <MapleUI/widget/object.h>
+#include <MapleUI/damage_region.h>
+#include <MapleUI/job_system.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+//
+// Builds random trees of 2000 to 5000 widgets, changes them at random a few widgets at a time,
+// and lays them out incrementally on a JobSystem with 4 workers after every change.
+// Each result must match a fresh single-threaded layout of a tree built anew from the same description.
+//
+
+
+
+namespace
+{
+
+using namespace maple;
+
+bool check_result(const std::string& name_, const std::string& difference_)
+{
+    if (difference_.empty())
+        std::cout << "PASS " << name_ << "\n";
+    else
+        std::cout << "FAIL " << name_ << ": " << difference_ << "\n";
+    return difference_.empty();
+}
+
+std::string to_string(const Rect& rect_)
+{
+    return "(" + std::to_string(rect_.x) + ", " + std::to_string(rect_.y) + ", "
+               + std::to_string(rect_.width) + ", " + std::to_string(rect_.height) + ")";
+}
+
+//
+// A widget with content of a given size, standing in for text.
+//
+class Label : public Frame
+{
+public:
+    static std::shared_ptr<Label> create(std::shared_ptr<Object> parent_, const Size& content_size_)
+    {
+        struct MakeSharedEnabler : public Label
+        {
+            MakeSharedEnabler(std::shared_ptr<Object> parent_)
+                : Label(parent_) {}
+        };
+        auto label = std::make_shared<MakeSharedEnabler>(parent_);
+        label->set_content_size(content_size_);
+        parent_->add_child(label);
+        return label;
+    }
+
+protected:
+    Label(std::shared_ptr<Object> parent_)
+        : Frame(parent_)
+    {
+        set_custom_measure(true);
+    }
+
+public:
+    virtual Size measure(const LayoutConstraints&) override
+    {
+        return m_content_size;
+    }
+
+    void set_content_size(const Size& content_size_)
+    {
+        m_content_size = content_size_;
+        invalidate_layout();
+    }
+
+private:
+    Size m_content_size{};
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// One widget of a tree. The root is the first node, the fixed-size panels below it follow,
+// and every other node comes after its parent. Removed nodes keep their index.
+//
+struct Node
+{
+    std::size_t parent{ 0 };
+    bool is_container{ false };
+    bool is_removed{ false };
+    LayoutStyle style{};
+    Size content_size{};
+};
+
+struct Description
+{
+    Rect root_rect{};
+    std::size_t panel_count{ 0 };
+    std::vector<Node> nodes;
+};
+
+//
+// Containers are always rows or columns, since children of a container without direction keep the rect
+// an earlier layout gave them, which a fresh tree cannot know.
+//
+LayoutStyle make_style(std::mt19937& random_, bool is_container_)
+{
+    auto pick = [&random_](int count_) { return static_cast<int>(random_() % count_); };
+
+    LayoutStyle style;
+    if (is_container_)
+        style.direction = pick(2) ? FlexDirection::row : FlexDirection::column;
+    style.justify = static_cast<FlexJustify>(pick(4));
+    style.align = static_cast<FlexAlign>(pick(4));
+    style.padding = pick(4);
+    style.gap = pick(3);
+    if (pick(5) == 0)
+        style.width = 10 + pick(200);
+    if (pick(5) == 0)
+        style.height = 10 + pick(200);
+    if (pick(3) == 0)
+        style.grow = static_cast<float>(1 + pick(3));
+    style.shrink = static_cast<float>(pick(3));
+    return style;
+}
+
+Size make_content_size(std::mt19937& random_)
+{
+    return Size{ .width = 4 + static_cast<int>(random_() % 40), .height = 6 + static_cast<int>(random_() % 20) };
+}
+
+//
+// A new node below a random container that is not removed.
+//
+Node make_node(std::mt19937& random_, const Description& description_)
+{
+    std::size_t parent = 0;
+    do
+        parent = description_.panel_count > 0 ? 1 + random_() % (description_.nodes.size() - 1) : 0;
+    while (!description_.nodes[parent].is_container || description_.nodes[parent].is_removed);
+
+    bool is_container = random_() % 10 < 3;
+    return Node{ .parent = parent, .is_container = is_container, .is_removed = false,
+                 .style = make_style(random_, is_container), .content_size = make_content_size(random_) };
+}
+
+Description make_description(std::mt19937& random_)
+{
+    Description description;
+    description.root_rect = Rect{ .x = 0, .y = 0, .width = 1920, .height = 1080 };
+    description.panel_count = 2 + random_() % 5;
+    std::size_t widget_count = 2000 + random_() % 3001;
+
+    description.nodes.push_back(Node{ .parent = 0, .is_container = true,
+                                      .style = LayoutStyle{ .direction = FlexDirection::row, .gap = 4 } });
+    for (std::size_t i = 0; i < description.panel_count; i++)
+    {
+        LayoutStyle style = make_style(random_, true);
+        style.width = 100 + static_cast<int>(random_() % 300);
+        style.height = 200 + static_cast<int>(random_() % 800);
+        description.nodes.push_back(Node{ .parent = 0, .is_container = true, .style = style });
+    }
+    while (description.nodes.size() < widget_count)
+        description.nodes.push_back(make_node(random_, description));
+    return description;
+}
+
+//
+// Creates one widget of the description below its parent, which has to exist already.
+//
+void add_object(std::vector<std::shared_ptr<Object>>& objects_, const Description& description_, std::size_t index_)
+{
+    const Node& node = description_.nodes[index_];
+    std::shared_ptr<Object> object;
+    if (index_ == 0)
+        object = Frame::create(nullptr, description_.root_rect, Color{});
+    else if (node.is_container)
+        object = Frame::create(objects_[node.parent]);
+    else
+        object = Label::create(objects_[node.parent], node.content_size);
+    object->set_layout_style(node.style);
+
+    if (objects_.size() <= index_)
+        objects_.resize(index_ + 1);
+    objects_[index_] = object;
+}
+
+std::vector<std::shared_ptr<Object>> build(const Description& description_)
+{
+    std::vector<std::shared_ptr<Object>> objects(description_.nodes.size());
+    for (std::size_t i = 0; i < description_.nodes.size(); i++)
+        if (!description_.nodes[i].is_removed)
+            add_object(objects, description_, i);
+    return objects;
+}
+
+//
+// Marks a node and every node below it as removed, and detaches it from the tree.
+//
+void remove_node(std::vector<std::shared_ptr<Object>>& objects_, Description& description_, std::size_t index_)
+{
+    objects_[index_]->remove();
+    description_.nodes[index_].is_removed = true;
+    for (std::size_t i = index_ + 1; i < description_.nodes.size(); i++)
+        if (description_.nodes[description_.nodes[i].parent].is_removed)
+            description_.nodes[i].is_removed = true;
+}
+
+//
+// One random change, applied to the description and to the tree laid out incrementally.
+//
+void change(std::mt19937& random_, std::vector<std::shared_ptr<Object>>& objects_, Description& description_)
+{
+    auto& nodes = description_.nodes;
+    std::size_t index = 1 + description_.panel_count + random_() % (nodes.size() - 1 - description_.panel_count);
+    if (nodes[index].is_removed)
+        return;
+
+    switch (random_() % 6)
+    {
+    case 0:
+    case 1:
+        if (!nodes[index].is_container)
+        {
+            nodes[index].content_size = make_content_size(random_);
+            std::static_pointer_cast<Label>(objects_[index])->set_content_size(nodes[index].content_size);
+        }
+        break;
+    case 2:
+        nodes[index].style = make_style(random_, nodes[index].is_container);
+        objects_[index]->set_layout_style(nodes[index].style);
+        break;
+    case 3:
+        nodes.push_back(make_node(random_, description_));
+        add_object(objects_, description_, nodes.size() - 1);
+        break;
+    case 4:
+        remove_node(objects_, description_, index);
+        break;
+    case 5:
+        description_.root_rect.width = 1600 + static_cast<int>(random_() % 640);
+        description_.root_rect.height = 900 + static_cast<int>(random_() % 360);
+        objects_[0]->set_rect(description_.root_rect);
+        break;
+    }
+}
+
+std::string compare_rects(const std::vector<std::shared_ptr<Object>>& actual_,
+                          const std::vector<std::shared_ptr<Object>>& expected_,
+                          const Description& description_)
+{
+    for (std::size_t i = 0; i < description_.nodes.size(); i++)
+    {
+        if (description_.nodes[i].is_removed)
+            continue;
+
+        const Rect& a = actual_[i]->get_rect();
+        const Rect& b = expected_[i]->get_rect();
+        if (a.x != b.x || a.y != b.y || a.width != b.width || a.height != b.height)
+            return "widget " + std::to_string(i) + " is at " + to_string(a) + " instead of " + to_string(b);
+    }
+    return {};
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+//
+// Changes one random tree 40 times, and compares it with a fresh tree after the first layout and every change.
+//
+bool check_random_tree(JobSystem& job_system_, std::uint32_t seed_)
+{
+    std::mt19937 random{ seed_ };
+    Description description = make_description(random);
+    auto objects = build(description);
+    DamageRegion damage;
+
+    std::string difference;
+    for (int round = 0; round <= 40 && difference.empty(); round++)
+    {
+        if (round > 0)
+            for (std::uint32_t i = 0, count = 1 + random() % 8; i < count; i++)
+                change(random, objects, description);
+
+        objects[0]->layout(&job_system_);
+        objects[0]->update(damage);
+
+        auto expected = build(description);
+        expected[0]->layout();
+
+        difference = compare_rects(objects, expected, description);
+        if (!difference.empty())
+            difference = "after round " + std::to_string(round) + ", " + difference;
+    }
+
+    std::size_t widget_count = std::ranges::count_if(description.nodes, [](const Node& node_) { return !node_.is_removed; });
+    return check_result("random_tree_" + std::to_string(seed_) + " (" + std::to_string(widget_count) + " widgets)",
+                        difference);
+}
+
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    auto job_system = JobSystem::create(4);
+
+    bool is_passed = true;
+    for (std::uint32_t seed = 1; seed <= 8; seed++)
+        is_passed &= check_random_tree(*job_system, seed);
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}